@@ -0,0 +1,182 @@
+#include "DeviceAdmission.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QStorageInfo>
+
+#include <algorithm>
+#include <string>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#include <winioctl.h>
+#endif
+
+DeviceAdmission::Device DeviceAdmission::deviceOf(const QString& path)
+{
+  if (path.isEmpty())
+  {
+    return Device();
+  }
+
+  // the output does not exist yet, its directory does
+  const QFileInfo wInfo(path);
+  const QStorageInfo wStorage(wInfo.exists() ? wInfo.absoluteFilePath() : wInfo.absolutePath());
+  const QString wRootPath = wStorage.isValid() ? wStorage.rootPath() : wInfo.absolutePath().left(3);
+
+  auto wIt = mDevices.find(wRootPath);
+  if (wIt == mDevices.end())
+  {
+    wIt = mDevices.emplace(wRootPath, Device{ wRootPath, detectType(wRootPath) }).first;
+  }
+  return wIt->second;
+}
+
+qint64 DeviceAdmission::availableBytes(const QString& path)
+{
+  const QFileInfo wInfo(path);
+  const QStorageInfo wStorage(wInfo.exists() ? wInfo.absoluteFilePath() : wInfo.absolutePath());
+  return wStorage.isValid() && wStorage.isReady() ? wStorage.bytesAvailable() : -1;
+}
+
+void DeviceAdmission::setDefaultReaderLimit(const unsigned limit)
+{
+  mDefaultReaderLimit = std::max(1u, limit);
+}
+
+unsigned DeviceAdmission::readerLimit(const DeviceType type) const
+{
+  auto wIt = mLearning.find(type);
+  if (wIt != mLearning.end() && wIt->second.mLimit > 0)
+  {
+    return wIt->second.mLimit;
+  }
+
+  // until there is something learned, flash storage is not punished for the seeks of the spindles
+  return type == DeviceType::SolidState ? std::min(sMaxLimit, mDefaultReaderLimit * 2) : mDefaultReaderLimit;
+}
+
+bool DeviceAdmission::recordThroughput(const DeviceType type, const unsigned concurrency, const double bytesPerSecond)
+{
+  if (concurrency == 0 || bytesPerSecond <= 0.0)
+  {
+    return false;
+  }
+
+  Learning& wLearning = mLearning[type];
+  if (wLearning.mLimit == 0)
+  {
+    wLearning.mLimit = readerLimit(type);
+  }
+
+  double& wThroughput = wLearning.mThroughput[concurrency];
+  wThroughput = wThroughput > 0.0 ? 0.7 * wThroughput + 0.3 * bytesPerSecond : bytesPerSecond;
+  ++wLearning.mSamples[concurrency];
+
+  const unsigned wLimit = wLearning.mLimit;
+  if (concurrency != wLimit || wLearning.mSamples[wLimit] < sMinSamples)
+  {
+    return false;
+  }
+
+  auto wKnown = [&wLearning](unsigned level) {
+    auto wIt = wLearning.mSamples.find(level);
+    return wIt != wLearning.mSamples.end() && wIt->second >= sMinSamples;
+  };
+
+  // back off if the current level is no real gain over the one below, probe the one above if it is not known yet
+  if (wLimit > 1 && wKnown(wLimit - 1) && wLearning.mThroughput[wLimit] < wLearning.mThroughput[wLimit - 1] * sGainThreshold)
+  {
+    wLearning.mLimit = wLimit - 1;
+  }
+  else if (wLimit < sMaxLimit && !wKnown(wLimit + 1))
+  {
+    wLearning.mLimit = wLimit + 1;
+  }
+  else if (wLimit < sMaxLimit && wLearning.mThroughput[wLimit + 1] >= wLearning.mThroughput[wLimit] * sGainThreshold)
+  {
+    wLearning.mLimit = wLimit + 1;
+  }
+  return wLearning.mLimit != wLimit;
+}
+
+std::map<QString, int> DeviceAdmission::learnedLimits() const
+{
+  std::map<QString, int> wLimits;
+  for (const auto& wLearning : mLearning)
+  {
+    if (wLearning.second.mLimit > 0)
+    {
+      wLimits[typeName(wLearning.first)] = static_cast<int>(wLearning.second.mLimit);
+    }
+  }
+  return wLimits;
+}
+
+void DeviceAdmission::setLearnedLimits(const std::map<QString, int>& limits)
+{
+  for (const DeviceType wType : { DeviceType::Unknown, DeviceType::Rotational, DeviceType::SolidState, DeviceType::Network })
+  {
+    auto wIt = limits.find(typeName(wType));
+    if (wIt != limits.end() && wIt->second > 0)
+    {
+      mLearning[wType].mLimit = std::min(sMaxLimit, static_cast<unsigned>(wIt->second));
+    }
+  }
+}
+
+QString DeviceAdmission::typeName(const DeviceType type)
+{
+  switch (type)
+  {
+    case DeviceType::Rotational:
+      return "hdd";
+    case DeviceType::SolidState:
+      return "ssd";
+    case DeviceType::Network:
+      return "network";
+    case DeviceType::Unknown:
+    default:
+      return "unknown";
+  }
+}
+
+DeviceAdmission::DeviceType DeviceAdmission::detectType(const QString& rootPath)
+{
+#ifdef Q_OS_WIN
+  const std::wstring wRoot = QDir::toNativeSeparators(rootPath).toStdWString(); // "C:\"
+  if (GetDriveTypeW(wRoot.c_str()) == DRIVE_REMOTE)
+  {
+    return DeviceType::Network;
+  }
+  if (wRoot.size() < 2 || wRoot[1] != L':')
+  {
+    return DeviceType::Unknown; // mounted folders are not resolved to their volume
+  }
+
+  // no access right is needed for the storage property queries
+  const std::wstring wVolume = L"\\\\.\\" + wRoot.substr(0, 2);
+  HANDLE wHandle = CreateFileW(wVolume.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+  if (wHandle == INVALID_HANDLE_VALUE)
+  {
+    return DeviceType::Unknown;
+  }
+
+  STORAGE_PROPERTY_QUERY wQuery = {};
+  wQuery.PropertyId = StorageDeviceSeekPenaltyProperty;
+  wQuery.QueryType = PropertyStandardQuery;
+  DEVICE_SEEK_PENALTY_DESCRIPTOR wDescriptor = {};
+  DWORD wBytes = 0;
+  const BOOL wOk = DeviceIoControl(wHandle, IOCTL_STORAGE_QUERY_PROPERTY, &wQuery, sizeof(wQuery), &wDescriptor, sizeof(wDescriptor), &wBytes, nullptr);
+  CloseHandle(wHandle);
+
+  if (!wOk || wBytes < sizeof(wDescriptor))
+  {
+    return DeviceType::Unknown;
+  }
+  return wDescriptor.IncursSeekPenalty ? DeviceType::Rotational : DeviceType::SolidState;
+#else
+  Q_UNUSED(rootPath);
+  return DeviceType::Unknown;
+#endif
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QString>
+
+#include <map>
+
+// knows the volume and the kind of storage behind the paths, and learns how many concurrent streams a kind of storage serves best
+class DeviceAdmission
+{
+public:
+  enum class DeviceType { Unknown, Rotational, SolidState, Network };
+
+  struct Device
+  {
+    QString mId;   // root path of the volume, empty for unknown paths
+                   // a volume is not a disk: the partitions of one disk count as separate devices, a spanned volume as one
+    DeviceType mType = DeviceType::Unknown;
+  };
+
+  Device deviceOf(const QString& path);
+  static qint64 availableBytes(const QString& path); // -1 if unknown
+
+  void setDefaultReaderLimit(const unsigned limit);
+  unsigned readerLimit(const DeviceType type) const;
+
+  // aggregate throughput of a device type at a concurrency level, the limit climbs while more streams bring more bytes
+  // returns true if the limit of the type changed
+  bool recordThroughput(const DeviceType type, const unsigned concurrency, const double bytesPerSecond);
+
+  std::map<QString, int> learnedLimits() const; // by type name, for the settings
+  void setLearnedLimits(const std::map<QString, int>& limits);
+
+  static QString typeName(const DeviceType type);
+
+private:
+  struct Learning
+  {
+    unsigned mLimit = 0;
+    std::map<unsigned, double> mThroughput; // bytes/s of all streams by concurrency, smoothed
+    std::map<unsigned, unsigned> mSamples;
+  };
+
+  static DeviceType detectType(const QString& rootPath);
+
+  std::map<QString, Device> mDevices; // by root path
+  std::map<DeviceType, Learning> mLearning;
+  unsigned mDefaultReaderLimit = 2;
+
+  static constexpr unsigned sMaxLimit = 8;
+  static constexpr unsigned sMinSamples = 3;  // per concurrency level before deciding
+  static constexpr double sGainThreshold = 1.1; // a level has to bring 10% more to be kept
+};
@@ -0,0 +1,78 @@
+#include "DurationProber.h"
+
+#include <QProcess>
+
+#include <algorithm>
+
+DurationProber::DurationProber(const QString& ffprobePath, QObject* parent)
+  : QObject(parent)
+  , mFFProbePath(ffprobePath)
+{}
+
+DurationProber::~DurationProber()
+{
+  for (auto& wProcess : mRunning)
+  {
+    wProcess->disconnect(this);
+    wProcess->kill();
+    wProcess->waitForFinished(1000);
+  }
+}
+
+void DurationProber::probe(const std::vector<QUrl>& videos)
+{
+  mQueue.insert(mQueue.end(), videos.begin(), videos.end());
+  startNext();
+}
+
+void DurationProber::setMaxRunning(const unsigned maxRunning)
+{
+  mMaxRunning = std::max(1u, maxRunning);
+  startNext();
+}
+
+void DurationProber::startNext()
+{
+  while (!mQueue.empty() && mRunning.size() < mMaxRunning)
+  {
+    const QUrl wVideo = mQueue.front();
+    mQueue.pop_front();
+
+    mRunning.push_back(std::make_unique<QProcess>());
+    QProcess* wProcess = mRunning.back().get();
+
+    auto wDone = [this, wProcess, wVideo](const VTime& duration) {
+      auto wIt = std::find_if(mRunning.begin(), mRunning.end(), [wProcess](const auto& process) { return process.get() == wProcess; });
+      if (wIt == mRunning.end())
+      {
+        return;
+      }
+      wIt->release()->deleteLater(); // we are in a signal of the process
+      mRunning.erase(wIt);
+
+      emit probed(wVideo, duration);
+      startNext();
+      if (mQueue.empty() && mRunning.empty())
+      {
+        emit finished();
+      }
+    };
+
+    connect(wProcess, &QProcess::finished, this, [wProcess, wDone](int exitCode, QProcess::ExitStatus exitStatus) {
+      bool wOk = false;
+      const double wSeconds = QString::fromLocal8Bit(wProcess->readAllStandardOutput()).trimmed().toDouble(&wOk);
+      wDone(exitCode == 0 && wOk ? VTime(static_cast<qint64>(wSeconds * 1000.0)) : VTime(0));
+      });
+    connect(wProcess, &QProcess::errorOccurred, this, [wDone](QProcess::ProcessError error) {
+      if (error == QProcess::FailedToStart)
+      {
+        wDone(VTime(0));
+      }
+      });
+
+    wProcess->start(mFFProbePath, { "-v", "error",
+                                    "-show_entries", "format=duration",
+                                    "-of", "default=noprint_wrappers=1:nokey=1",
+                                    wVideo.toLocalFile() });
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "VTime.h"
+
+#include <QObject>
+#include <QString>
+#include <QUrl>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+class QProcess;
+
+// reads the duration of videos with ffprobe in the background, a few files at a time
+class DurationProber : public QObject
+{
+  Q_OBJECT
+
+public:
+  DurationProber(const QString& ffprobePath, QObject* parent = nullptr);
+  ~DurationProber();
+
+  void probe(const std::vector<QUrl>& videos);
+  void setMaxRunning(const unsigned maxRunning);
+
+signals:
+  void probed(const QUrl& video, VTime duration); // duration is 0 if it could not be read
+  void finished();
+
+private:
+  void startNext();
+
+  const QString mFFProbePath;
+  std::deque<QUrl> mQueue;
+  std::vector<std::unique_ptr<QProcess>> mRunning;
+  unsigned mMaxRunning = 4;
+};
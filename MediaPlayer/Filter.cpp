@@ -0,0 +1,393 @@
+#include "Filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+QString number(double value)
+{
+  return QString::number(value, 'g', 6);
+}
+
+// scale a dimension along with a crop, keeps the "auto" values and the even sizes needed by the encoders
+int cropDimension(int dimension, double fraction)
+{
+  if (dimension <= 0)
+  {
+    return dimension;
+  }
+  return std::max(2, static_cast<int>(std::lround(dimension * fraction / 2.0)) * 2);
+}
+
+}
+
+Filter::Filter(Type type)
+  : mType(type)
+{}
+
+Filter Filter::decimate(int step)
+{
+  Filter wFilter(Type::Decimate);
+  wFilter.mValue = std::max(1, step);
+  return wFilter;
+}
+
+Filter Filter::deinterlace()
+{
+  return Filter(Type::Deinterlace);
+}
+
+Filter Filter::crop(const QRectF& area)
+{
+  Filter wFilter(Type::Crop);
+  wFilter.mArea = area.intersected(QRectF(0.0, 0.0, 1.0, 1.0));
+  return wFilter;
+}
+
+Filter Filter::scale(int width, int height)
+{
+  Filter wFilter(Type::Scale);
+  wFilter.mWidth = width;
+  wFilter.mHeight = height;
+  return wFilter;
+}
+
+Filter Filter::fps(double fps)
+{
+  Filter wFilter(Type::Fps);
+  wFilter.mValue = fps;
+  return wFilter;
+}
+
+Filter Filter::speed(double factor)
+{
+  Filter wFilter(Type::Speed);
+  wFilter.mValue = factor;
+  return wFilter;
+}
+
+Filter Filter::reverse()
+{
+  return Filter(Type::Reverse);
+}
+
+Filter Filter::audioNormalize()
+{
+  return Filter(Type::AudioNormalize);
+}
+
+Filter::Type Filter::type() const
+{
+  return mType;
+}
+
+const QRectF& Filter::area() const
+{
+  return mArea;
+}
+
+int Filter::width() const
+{
+  return mWidth;
+}
+
+int Filter::height() const
+{
+  return mHeight;
+}
+
+double Filter::value() const
+{
+  return mValue;
+}
+
+FilterChain& FilterChain::add(const Filter& filter)
+{
+  mFilters.push_back(filter);
+  return *this;
+}
+
+void FilterChain::clear()
+{
+  mFilters.clear();
+}
+
+bool FilterChain::empty() const
+{
+  return mFilters.empty();
+}
+
+bool FilterChain::has(Filter::Type type) const
+{
+  return std::any_of(mFilters.begin(), mFilters.end(), [type](const Filter& filter) { return filter.type() == type; });
+}
+
+FilterChain FilterChain::optimized() const
+{
+  int wDecimate = 1;
+  bool wDeinterlace = false;
+  QRectF wCrop(0.0, 0.0, 1.0, 1.0);
+  bool wScale = false;
+  int wWidth = -2;
+  int wHeight = -2;
+  double wFps = 0.0;
+  double wSpeed = 1.0;
+  bool wReverse = false;
+  bool wNormalize = false;
+
+  for (const Filter& wFilter : mFilters)
+  {
+    switch (wFilter.type())
+    {
+      case Filter::Type::Decimate:
+        wDecimate *= static_cast<int>(wFilter.value()); // dropped frames are never processed, it goes before everything
+        break;
+      case Filter::Type::Deinterlace:
+        wDeinterlace = true; // yadif must see the original fields, it goes before the rest
+        break;
+      case Filter::Type::Crop:
+      {
+        const QRectF& wArea = wFilter.area();
+        if (wScale)
+        {
+          // crop after scale is the same area cropped before it with a proportionally smaller scale
+          wWidth = cropDimension(wWidth, wArea.width());
+          wHeight = cropDimension(wHeight, wArea.height());
+        }
+        wCrop = QRectF(wCrop.x() + wArea.x() * wCrop.width()
+                       , wCrop.y() + wArea.y() * wCrop.height()
+                       , wArea.width() * wCrop.width()
+                       , wArea.height() * wCrop.height());
+        break;
+      }
+      case Filter::Type::Scale:
+        wScale = true; // only the last of consecutive scales matters
+        wWidth = wFilter.width();
+        wHeight = wFilter.height();
+        break;
+      case Filter::Type::Fps:
+        wFps = wFilter.value();
+        break;
+      case Filter::Type::Speed:
+        wSpeed *= wFilter.value();
+        if (wFps > 0.0)
+        {
+          wFps *= wFilter.value(); // a speed change after a fixed rate scales the rate as well
+        }
+        break;
+      case Filter::Type::Reverse:
+        wReverse = !wReverse;
+        break;
+      case Filter::Type::AudioNormalize:
+        wNormalize = true;
+        break;
+    }
+  }
+
+  FilterChain wChain;
+  if (wDecimate > 1)
+  {
+    wChain.add(Filter::decimate(wDecimate));
+  }
+  if (wDeinterlace)
+  {
+    wChain.add(Filter::deinterlace());
+  }
+  if (wCrop != QRectF(0.0, 0.0, 1.0, 1.0))
+  {
+    wChain.add(Filter::crop(wCrop));
+  }
+  if (wScale && (wWidth > 0 || wHeight > 0))
+  {
+    wChain.add(Filter::scale(wWidth, wHeight));
+  }
+  if (wSpeed > 0.0 && std::abs(wSpeed - 1.0) > 1e-6)
+  {
+    wChain.add(Filter::speed(wSpeed));
+  }
+  if (wFps > 0.0)
+  {
+    wChain.add(Filter::fps(wFps)); // after the speed change and before reverse, so reverse buffers less frames
+  }
+  if (wReverse)
+  {
+    wChain.add(Filter::reverse());
+  }
+  if (wNormalize)
+  {
+    wChain.add(Filter::audioNormalize());
+  }
+  return wChain;
+}
+
+double FilterChain::speed() const
+{
+  double wSpeed = 1.0;
+  for (const Filter& wFilter : mFilters)
+  {
+    if (wFilter.type() == Filter::Type::Speed)
+    {
+      wSpeed *= wFilter.value();
+    }
+  }
+  return wSpeed > 0.0 ? wSpeed : 1.0;
+}
+
+QString FilterChain::videoGraph() const
+{
+  QStringList wGraph;
+  for (const Filter& wFilter : optimized().mFilters)
+  {
+    switch (wFilter.type())
+    {
+      case Filter::Type::Decimate:
+        wGraph.push_back(QString("select='not(mod(n,%1))'").arg(static_cast<int>(wFilter.value())));
+        break;
+      case Filter::Type::Deinterlace:
+        wGraph.push_back("yadif");
+        break;
+      case Filter::Type::Crop:
+      {
+        const QRectF& wArea = wFilter.area();
+        wGraph.push_back(QString("crop=trunc(iw*%1/2)*2:trunc(ih*%2/2)*2:iw*%3:ih*%4")
+                         .arg(number(wArea.width()), number(wArea.height()), number(wArea.x()), number(wArea.y())));
+        break;
+      }
+      case Filter::Type::Scale:
+        wGraph.push_back(QString("scale=%1:%2").arg(wFilter.width()).arg(wFilter.height()));
+        break;
+      case Filter::Type::Speed:
+        wGraph.push_back(QString("setpts=PTS/%1").arg(number(wFilter.value())));
+        break;
+      case Filter::Type::Fps:
+        wGraph.push_back(QString("fps=%1").arg(number(wFilter.value())));
+        break;
+      case Filter::Type::Reverse:
+        wGraph.push_back("reverse");
+        break;
+      case Filter::Type::AudioNormalize:
+        break;
+    }
+  }
+  return wGraph.join(',');
+}
+
+QString FilterChain::audioGraph() const
+{
+  QStringList wGraph;
+  for (const Filter& wFilter : optimized().mFilters)
+  {
+    switch (wFilter.type())
+    {
+      case Filter::Type::Speed:
+      {
+        // atempo is limited to [0.5, 2.0] on older ffmpeg builds, chain it for bigger changes
+        double wTempo = wFilter.value();
+        while (wTempo > 2.0)
+        {
+          wGraph.push_back("atempo=2.0");
+          wTempo /= 2.0;
+        }
+        while (wTempo < 0.5)
+        {
+          wGraph.push_back("atempo=0.5");
+          wTempo /= 0.5;
+        }
+        wGraph.push_back(QString("atempo=%1").arg(number(wTempo)));
+        break;
+      }
+      case Filter::Type::Reverse:
+        wGraph.push_back("areverse");
+        break;
+      case Filter::Type::AudioNormalize:
+        wGraph.push_back("loudnorm");
+        break;
+      default:
+        break;
+    }
+  }
+  return wGraph.join(',');
+}
+
+QStringList FilterChain::arguments() const
+{
+  QStringList wArguments;
+
+  const QString wVideoGraph = videoGraph();
+  if (!wVideoGraph.isEmpty())
+  {
+    wArguments.append({ "-vf", wVideoGraph });
+  }
+
+  const QString wAudioGraph = audioGraph();
+  if (!wAudioGraph.isEmpty())
+  {
+    wArguments.append({ "-af", wAudioGraph });
+  }
+  return wArguments;
+}
+
+QString FilterChain::complexGraph(const std::vector<int>& heights, const bool audio) const
+{
+  // the renditions bring their own scale, reverse goes after it so it buffers the smaller frames
+  FilterChain wCommon;
+  bool wReverse = false;
+  for (const Filter& wFilter : optimized().mFilters)
+  {
+    if (wFilter.type() == Filter::Type::Reverse)
+    {
+      wReverse = true;
+    }
+    else if (wFilter.type() != Filter::Type::Scale)
+    {
+      wCommon.add(wFilter);
+    }
+  }
+
+  const size_t wCount = std::max<size_t>(1, heights.size());
+
+  QString wGraph = "[0:v]";
+  const QString wVideoGraph = wCommon.videoGraph();
+  if (!wVideoGraph.isEmpty())
+  {
+    wGraph += wVideoGraph + ",";
+  }
+  wGraph += QString("split=%1").arg(wCount);
+  for (size_t i = 0; i < wCount; ++i)
+  {
+    wGraph += QString("[s%1]").arg(i);
+  }
+  for (size_t i = 0; i < wCount; ++i)
+  {
+    wGraph += QString(";[s%1]").arg(i);
+    wGraph += heights.empty() ? QString("null") : QString("scale=-2:%1").arg(heights[i]);
+    wGraph += wReverse ? ",reverse" : "";
+    wGraph += QString("[v%1]").arg(i);
+  }
+
+  // a missing input pad fails the whole graph, the outputs map the audio with 0:a? then
+  const QString wAudioGraph = audioGraph();
+  if (audio && !wAudioGraph.isEmpty())
+  {
+    wGraph += ";[0:a]" + wAudioGraph + QString(",asplit=%1").arg(wCount);
+    for (size_t i = 0; i < wCount; ++i)
+    {
+      wGraph += QString("[a%1]").arg(i);
+    }
+  }
+  return wGraph;
+}
+
+QString FilterChain::paletteGraph() const
+{
+  QString wGraph = "[0:v]";
+  const QString wVideoGraph = videoGraph();
+  if (!wVideoGraph.isEmpty())
+  {
+    wGraph += wVideoGraph + ",";
+  }
+  wGraph += "split[s0][s1];[s0]palettegen=stats_mode=diff[p];[s1][p]paletteuse=dither=bayer:diff_mode=rectangle[v]";
+  return wGraph;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QRectF>
+
+#include <vector>
+
+// a single processing step of a cut job
+class Filter
+{
+public:
+  enum class Type { Decimate, Deinterlace, Crop, Scale, Fps, Speed, Reverse, AudioNormalize };
+
+  static Filter decimate(int step);               // keeps every step-th frame
+  static Filter deinterlace();
+  static Filter crop(const QRectF& area);         // area is normalized to the input frame, (0, 0, 1, 1) is the full frame
+  static Filter scale(int width, int height);     // -2 keeps the aspect ratio, see ffmpeg scale filter
+  static Filter fps(double fps);
+  static Filter speed(double factor);
+  static Filter reverse();
+  static Filter audioNormalize();
+
+  Type type() const;
+  const QRectF& area() const;
+  int width() const;
+  int height() const;
+  double value() const;
+
+private:
+  explicit Filter(Type type);
+
+  Type mType;
+  QRectF mArea = QRectF(0.0, 0.0, 1.0, 1.0);
+  int mWidth = -2;
+  int mHeight = -2;
+  double mValue = 1.0;
+};
+
+// ordered list of filters, compiled into one ffmpeg filtergraph so any combination costs a single decode/encode pass
+class FilterChain
+{
+public:
+  FilterChain() = default;
+
+  FilterChain& add(const Filter& filter);
+  void clear();
+  bool empty() const;
+  bool has(Filter::Type type) const;
+
+  // folds the chain into its canonical form: frame dropping and deinterlace first, crops composed and moved before the scale,
+  // consecutive scales and fps changes collapsed, speeds multiplied, reverse pairs cancelled
+  FilterChain optimized() const;
+
+  double speed() const; // overall speed factor, output time * speed = source time
+
+  QString videoGraph() const;  // "yadif,crop=...,scale=..." or empty
+  QString audioGraph() const;  // "atempo=...,areverse,loudnorm" or empty
+  QStringList arguments() const; // -vf/-af arguments, empty if there is nothing to do
+
+  // one filter_complex for several outputs sharing the decode and the common filters,
+  // output i is labeled [v<i>] scaled to heights[i] and, if the input has audio and it is filtered, [a<i>]
+  QString complexGraph(const std::vector<int>& heights, const bool audio) const;
+
+  // palettegen and paletteuse on a split of the same decoded frames, the output is labeled [v]
+  // paletteuse holds every frame until palettegen sees the end of its input, the input must be trimmed to the range
+  QString paletteGraph() const;
+
+private:
+  std::vector<Filter> mFilters;
+};
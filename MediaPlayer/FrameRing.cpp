@@ -0,0 +1,193 @@
+#include "FrameRing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+void FrameRing::setBudget(const qint64 bytes)
+{
+  mBudget = std::max<qint64>(0, bytes);
+  evict();
+}
+
+void FrameRing::clear()
+{
+  mFrames.clear();
+  mPending.clear();
+  mBytes = 0;
+}
+
+void FrameRing::insert(const QVideoFrame& frame, const bool playing)
+{
+  if (!frame.isValid() || frame.startTime() < 0 || mBudget <= 0)
+  {
+    return;
+  }
+
+  mCurrent = frame.startTime();
+  if (frame.handleType() == QVideoFrame::NoHandle)
+  {
+    add(frame);
+    return;
+  }
+  if (playing)
+  {
+    mPending.push_back(frame);
+    if (mPending.size() > sMaxPending)
+    {
+      mPending.pop_front(); // back to the decoder
+    }
+    return;
+  }
+  flushPending();
+  add(frame);
+}
+
+void FrameRing::setCurrent(const qint64 startTime)
+{
+  mCurrent = startTime;
+}
+
+std::optional<QVideoFrame> FrameRing::previous(const qint64 startTime)
+{
+  flushPending();
+  auto wIt = mFrames.find(startTime);
+  if (wIt == mFrames.end() || wIt == mFrames.begin())
+  {
+    return std::nullopt;
+  }
+  const QVideoFrame& wPrevious = std::prev(wIt)->second;
+  if (!adjacent(wPrevious, wIt->second))
+  {
+    return std::nullopt;
+  }
+  return wPrevious;
+}
+
+std::optional<QVideoFrame> FrameRing::next(const qint64 startTime)
+{
+  flushPending();
+  auto wIt = mFrames.find(startTime);
+  if (wIt == mFrames.end() || std::next(wIt) == mFrames.end())
+  {
+    return std::nullopt;
+  }
+  const QVideoFrame& wNext = std::next(wIt)->second;
+  if (!adjacent(wIt->second, wNext))
+  {
+    return std::nullopt;
+  }
+  return wNext;
+}
+
+qint64 FrameRing::frameBytes(const QVideoFrame& frame)
+{
+  int wBitsPerPixel = 32; // packed rgb and the rest
+  switch (frame.pixelFormat())
+  {
+    case QVideoFrameFormat::Format_YUV420P:
+    case QVideoFrameFormat::Format_YV12:
+    case QVideoFrameFormat::Format_NV12:
+    case QVideoFrameFormat::Format_NV21:
+    case QVideoFrameFormat::Format_IMC1:
+    case QVideoFrameFormat::Format_IMC2:
+    case QVideoFrameFormat::Format_IMC3:
+    case QVideoFrameFormat::Format_IMC4:
+      wBitsPerPixel = 12;
+      break;
+    case QVideoFrameFormat::Format_YUV422P:
+    case QVideoFrameFormat::Format_UYVY:
+    case QVideoFrameFormat::Format_YUYV:
+      wBitsPerPixel = 16;
+      break;
+    case QVideoFrameFormat::Format_P010:
+    case QVideoFrameFormat::Format_P016:
+    case QVideoFrameFormat::Format_YUV420P10:
+      wBitsPerPixel = 24;
+      break;
+    default:
+      break;
+  }
+  return static_cast<qint64>(frame.width()) * frame.height() * wBitsPerPixel / 8;
+}
+
+QVideoFrame FrameRing::toMemory(const QVideoFrame& frame)
+{
+  QVideoFrame wSource(frame);
+  if (!wSource.map(QVideoFrame::ReadOnly))
+  {
+    return QVideoFrame();
+  }
+
+  QVideoFrame wCopy(wSource.surfaceFormat());
+  if (!wCopy.map(QVideoFrame::WriteOnly))
+  {
+    wSource.unmap();
+    return QVideoFrame();
+  }
+  // row by row, the two sides may pad their lines differently
+  for (int i = 0; i < wSource.planeCount(); ++i)
+  {
+    const int wSourceLine = wSource.bytesPerLine(i);
+    const int wCopyLine = wCopy.bytesPerLine(i);
+    const int wRows = std::min(wSource.mappedBytes(i) / std::max(1, wSourceLine), wCopy.mappedBytes(i) / std::max(1, wCopyLine));
+    for (int wRow = 0; wRow < wRows; ++wRow)
+    {
+      std::memcpy(wCopy.bits(i) + wRow * wCopyLine, wSource.bits(i) + wRow * wSourceLine, std::min(wSourceLine, wCopyLine));
+    }
+  }
+  wCopy.unmap();
+  wSource.unmap();
+
+  wCopy.setStartTime(frame.startTime());
+  wCopy.setEndTime(frame.endTime());
+  return wCopy;
+}
+
+bool FrameRing::adjacent(const QVideoFrame& first, const QVideoFrame& second)
+{
+  // the end time is the start of the next frame, a missing one leaves a gap of at least half a frame
+  const qint64 wDuration = first.endTime() > first.startTime() ? first.endTime() - first.startTime() : 0;
+  return wDuration > 0 && std::abs(second.startTime() - first.endTime()) < wDuration / 2;
+}
+
+void FrameRing::add(const QVideoFrame& frame)
+{
+  // a frame shown again, e.g. after a seek back to it, is already here
+  const qint64 wStartTime = frame.startTime();
+  if (mFrames.count(wStartTime) > 0)
+  {
+    return;
+  }
+
+  const QVideoFrame wFrame = frame.handleType() == QVideoFrame::NoHandle ? frame : toMemory(frame);
+  if (!wFrame.isValid())
+  {
+    return;
+  }
+  mFrames.emplace(wStartTime, wFrame);
+  mBytes += frameBytes(wFrame);
+  evict();
+}
+
+void FrameRing::flushPending()
+{
+  const std::deque<QVideoFrame> wPending = std::move(mPending);
+  mPending.clear();
+  for (const QVideoFrame& wFrame : wPending)
+  {
+    add(wFrame);
+  }
+}
+
+void FrameRing::evict()
+{
+  while (mBytes > mBudget && !mFrames.empty())
+  {
+    auto wFirst = mFrames.begin();
+    auto wLast = std::prev(mFrames.end());
+    auto wFarthest = (mCurrent - wFirst->first) >= (wLast->first - mCurrent) ? wFirst : wLast;
+    mBytes -= frameBytes(wFarthest->second);
+    mFrames.erase(wFarthest);
+  }
+}
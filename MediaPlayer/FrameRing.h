@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QVideoFrame>
+
+#include <deque>
+#include <map>
+#include <optional>
+
+// the presented frames of the player with their own timestamps, frame steps are served from here
+// the memory is bounded by a byte budget, so the frame count follows the resolution, the frames farthest
+// from the one on screen go first: behind it while playing, on both sides while stepping
+// software frames are kept as they are shown, the budget holds the last seconds of the playback
+// gpu frames are read back to memory only while paused, the read back would cost the playback its smoothness:
+// of the playback only the last sMaxPending are held by reference and copied when a step needs them,
+// the budget is filled by the frames stepped to and shown while paused
+class FrameRing
+{
+public:
+  void setBudget(const qint64 bytes);
+  void clear();
+
+  void insert(const QVideoFrame& frame, const bool playing); // a frame of the decoder, held by reference
+  void setCurrent(const qint64 startTime);
+
+  // the frame right before or after the one starting at startTime (us), empty if there is a gap in the ring
+  std::optional<QVideoFrame> previous(const qint64 startTime);
+  std::optional<QVideoFrame> next(const qint64 startTime);
+
+private:
+  static qint64 frameBytes(const QVideoFrame& frame);
+  static QVideoFrame toMemory(const QVideoFrame& frame);
+  static bool adjacent(const QVideoFrame& first, const QVideoFrame& second);
+  void add(const QVideoFrame& frame);
+  void flushPending();
+  void evict();
+
+  std::map<qint64, QVideoFrame> mFrames; // by start time (us)
+  std::deque<QVideoFrame> mPending;      // gpu frames of the playback, not copied yet
+  qint64 mBytes = 0;
+  qint64 mBudget = 256 * 1024 * 1024;
+  qint64 mCurrent = 0;
+
+  static constexpr std::size_t sMaxPending = 3; // a texture stays in the pool of the decoder as long as it is referenced, the pool is small
+};
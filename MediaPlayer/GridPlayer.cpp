@@ -0,0 +1,223 @@
+#include "GridPlayer.h"
+#include "Playlist.h"
+#include "Utils.h"
+
+#include <QProcess>
+#include <QVideoSink>
+
+#include <algorithm>
+#include <cmath>
+
+GridPlayer::GridPlayer(const QString& ffmpegPath, QObject* parent)
+  : QObject(parent)
+  , mFFMpegPath(ffmpegPath)
+{
+  mFocusTimer.setSingleShot(true);
+  mFocusTimer.setInterval(sFocusDelayMs);
+  connect(&mFocusTimer, &QTimer::timeout, this, &GridPlayer::onFocusTimeout);
+}
+
+GridPlayer::~GridPlayer()
+{
+  stop();
+}
+
+void GridPlayer::start(const std::vector<QUrl>& videos, const std::vector<QVideoSink*>& sinks, const QSize& tileSize)
+{
+  stop();
+  mTileSize = QSize(tileSize.width() & ~1, tileSize.height() & ~1); // even sizes for the chroma planes
+  for (std::size_t i = 0; i < std::min(videos.size(), sinks.size()); ++i)
+  {
+    auto wTile = std::make_unique<Tile>();
+    wTile->mVideo = videos[i];
+    wTile->mSink = sinks[i];
+    const std::optional<Sequence> wRange = Playlist::range(videos[i]);
+    wTile->mPosition = wRange ? wRange->first : VTime(0);
+    mTiles.push_back(std::move(wTile));
+  }
+  distribute();
+}
+
+void GridPlayer::stop()
+{
+  for (auto& wTile : mTiles)
+  {
+    release(*wTile);
+  }
+  mTiles.clear();
+  mFocus.reset();
+  mFocusTimer.stop();
+}
+
+bool GridPlayer::isRunning() const
+{
+  return !mTiles.empty();
+}
+
+void GridPlayer::setBudget(const int fps)
+{
+  mBudget = std::max(1, fps);
+  distribute();
+}
+
+void GridPlayer::setFocus(const std::size_t index)
+{
+  if (index >= mTiles.size())
+  {
+    return;
+  }
+  mHovered = index;
+  if (mFocus == index)
+  {
+    mFocusTimer.stop(); // back on the focused tile before the delay
+    return;
+  }
+  mFocusTimer.start();
+}
+
+void GridPlayer::onFocusTimeout()
+{
+  if (mHovered >= mTiles.size() || mFocus == mHovered)
+  {
+    return;
+  }
+  mFocus = mHovered;
+  distribute();
+  emit focused(mHovered);
+}
+
+QUrl GridPlayer::video(const std::size_t index) const
+{
+  return index < mTiles.size() ? mTiles[index]->mVideo : QUrl();
+}
+
+VTime GridPlayer::position(const std::size_t index) const
+{
+  return index < mTiles.size() ? mTiles[index]->mPosition : VTime(0);
+}
+
+void GridPlayer::distribute()
+{
+  if (mTiles.empty())
+  {
+    return;
+  }
+
+  // the focused tile gets half of the budget, the rest is shared, without a focus every tile gets the same
+  const double wBudget = static_cast<double>(mBudget);
+  const double wCount = static_cast<double>(mTiles.size());
+  const bool wFocused = mFocus && mTiles.size() > 1;
+  const double wFocusFps = wFocused ? std::min(sMaxFps, wBudget / 2.0) : 0.0;
+  const double wOtherFps = wFocused ? (wBudget - wFocusFps) / (wCount - 1.0) : wBudget / wCount;
+
+  for (std::size_t i = 0; i < mTiles.size(); ++i)
+  {
+    Tile& wTile = *mTiles[i];
+    const double wFps = std::clamp(wFocused && *mFocus == i ? wFocusFps : wOtherFps, 1.0, sMaxFps);
+    const bool wKeyframesOnly = wFps < sKeyframeFps;
+    // a keyframe decoder costs the same at any share, a full one is restarted for a change of a whole frame
+    if (wTile.mProcess && wTile.mKeyframesOnly == wKeyframesOnly && (wKeyframesOnly || std::lround(wTile.mFps) == std::lround(wFps)))
+    {
+      continue;
+    }
+    wTile.mFps = wFps;
+    wTile.mKeyframesOnly = wKeyframesOnly;
+    launch(wTile);
+  }
+}
+
+void GridPlayer::launch(Tile& tile)
+{
+  release(tile);
+
+  const std::optional<Sequence> wRange = Playlist::range(tile.mVideo);
+  if (wRange && tile.mPosition >= wRange->second)
+  {
+    tile.mPosition = wRange->first;
+  }
+  tile.mStart = tile.mPosition;
+  tile.mFrames = 0;
+
+  // the frames the budget has no room for are not decoded at all with skip_frame, the fps filter only drops decoded ones
+  QStringList wArguments = { "-hide_banner", "-loglevel", "error" };
+  if (tile.mKeyframesOnly)
+  {
+    wArguments << "-skip_frame" << "nokey";
+  }
+  wArguments << "-ss" << tile.mStart.toString() << "-re" << "-i" << Playlist::fileUrl(tile.mVideo).toLocalFile();
+  if (wRange)
+  {
+    wArguments << "-t" << (wRange->second - tile.mStart).toString();
+  }
+  wArguments << "-an" << "-sn"
+             << "-vf" << QString("fps=%1,scale=%2:%3:force_original_aspect_ratio=decrease:force_divisible_by=2,pad=%2:%3:-1:-1")
+                           .arg(tile.mFps, 0, 'f', 2).arg(mTileSize.width()).arg(mTileSize.height())
+             << "-pix_fmt" << "yuv420p"
+             << "-f" << "rawvideo" << "pipe:1";
+
+  tile.mProcess = std::make_unique<QProcess>();
+  tile.mProcess->setStandardErrorFile(QProcess::nullDevice());
+  Tile* wTile = &tile;
+  connect(tile.mProcess.get(), &QProcess::readyReadStandardOutput, this, [this, wTile]() { onOutput(*wTile); });
+  connect(tile.mProcess.get(), &QProcess::finished, this, [this, wTile]() { onFinished(*wTile); });
+  tile.mProcess->start(mFFMpegPath, wArguments);
+}
+
+void GridPlayer::release(Tile& tile)
+{
+  if (!tile.mProcess)
+  {
+    return;
+  }
+  QProcess* wProcess = tile.mProcess.release();
+  wProcess->disconnect(this);
+  tile.mBuffer.clear();
+  if (wProcess->state() == QProcess::NotRunning)
+  {
+    delete wProcess; // e.g. failed to start, finished never comes
+    return;
+  }
+  wProcess->kill();
+  connect(wProcess, &QProcess::finished, wProcess, &QObject::deleteLater);
+}
+
+void GridPlayer::onOutput(Tile& tile)
+{
+  tile.mBuffer += tile.mProcess->readAllStandardOutput();
+
+  // only the last complete frame is shown, the sink would drop the rest anyway
+  const qsizetype wFrameBytes = static_cast<qsizetype>(mTileSize.width()) * mTileSize.height() * 3 / 2;
+  const qsizetype wCount = tile.mBuffer.size() / wFrameBytes;
+  if (wCount == 0)
+  {
+    return;
+  }
+  tile.mFrames += wCount;
+  const double wFrameMs = 1000.0 / tile.mFps;
+  tile.mPosition = tile.mStart + VTime(std::llround((tile.mFrames - 1) * wFrameMs));
+
+  const qint64 wStartTime = tile.mPosition.ms() * 1000;
+  const QVideoFrame wFrame = utils::yuv420pFrame(tile.mBuffer.constData() + (wCount - 1) * wFrameBytes, mTileSize, wStartTime, wStartTime + std::llround(wFrameMs * 1000.0));
+  tile.mBuffer.remove(0, wCount * wFrameBytes);
+  if (wFrame.isValid())
+  {
+    tile.mSink->setVideoFrame(wFrame);
+  }
+}
+
+void GridPlayer::onFinished(Tile& tile)
+{
+  QProcess* wProcess = tile.mProcess.release();
+  wProcess->disconnect(this);
+  wProcess->deleteLater(); // we are in its signal
+  tile.mBuffer.clear();
+
+  // the entry plays over and over while it is on the grid, a decoder that gave nothing is not restarted
+  if (tile.mFrames == 0)
+  {
+    return;
+  }
+  const std::optional<Sequence> wRange = Playlist::range(tile.mVideo);
+  tile.mPosition = wRange ? wRange->first : VTime(0);
+  launch(tile);
+}
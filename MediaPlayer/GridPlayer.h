@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Types.h"
+
+#include <QObject>
+#include <QSize>
+#include <QTimer>
+#include <QUrl>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+class QProcess;
+class QVideoSink;
+
+// the tiles of the multi-view: one ffmpeg per tile, scaled down to the tile and read at the speed of the clock (-re)
+// the decode budget is the frames per second of all the tiles together, the focused tile gets the most of it,
+// the tiles left with less than sKeyframeFps decode only the keyframes, a share change restarts the decoder from its position
+// the focus follows the mouse only once it stays on a tile, passing over the grid restarts nothing
+class GridPlayer : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit GridPlayer(const QString& ffmpegPath, QObject* parent = nullptr);
+  ~GridPlayer();
+
+  void start(const std::vector<QUrl>& videos, const std::vector<QVideoSink*>& sinks, const QSize& tileSize);
+  void stop();
+  bool isRunning() const;
+
+  void setBudget(const int fps);
+  void setFocus(const std::size_t index); // the tile under the mouse, it gets the focus after sFocusDelayMs there
+
+  QUrl video(const std::size_t index) const;
+  VTime position(const std::size_t index) const; // of the frame on screen
+
+signals:
+  void focused(std::size_t index);
+
+private:
+  struct Tile
+  {
+    QUrl mVideo;
+    QVideoSink* mSink = nullptr;
+    std::unique_ptr<QProcess> mProcess;
+    QByteArray mBuffer;
+    double mFps = 0.0;
+    bool mKeyframesOnly = false;
+    VTime mStart;     // of the running decode
+    VTime mPosition;  // of the frame on screen
+    qint64 mFrames = 0; // since mStart
+  };
+
+  void onFocusTimeout();
+  void distribute();
+  void launch(Tile& tile);
+  void release(Tile& tile);
+  void onOutput(Tile& tile);
+  void onFinished(Tile& tile);
+
+  const QString mFFMpegPath;
+  std::vector<std::unique_ptr<Tile>> mTiles; // the decoder signals point to them
+  std::optional<std::size_t> mFocus;
+  std::size_t mHovered = 0;
+  QTimer mFocusTimer;
+  QSize mTileSize;
+  int mBudget = 60;
+
+  static constexpr double sMaxFps = 30.0;
+  static constexpr double sKeyframeFps = 8.0;
+  static constexpr int sFocusDelayMs = 175;
+};
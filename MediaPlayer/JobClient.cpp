@@ -0,0 +1,469 @@
+#include "JobClient.h"
+#include "JobProtocol.h"
+#include "SpscQueue.h"
+
+#include <QLocalSocket>
+#include <QProcess>
+
+// a message of the daemon, decoded on the i/o thread
+struct JobClient::Event
+{
+  enum class Type { Accepted, Refused, Started, Progress, Rejected, Finished, Limits, Disconnected };
+
+  Type mType = Type::Progress;
+  Job::Id mId = 0;        // daemon id
+  Job::Id mTag = 0;       // Accepted, Refused: the local id
+  VTime mTime;            // Progress
+  bool mSucceeded = false; // Finished
+  QString mReason;        // Rejected, Refused
+  std::map<QString, int> mLimits;
+};
+
+class JobClient::Connection : public QObject
+{
+public:
+  Connection()
+  {
+    connect(&mSocket, &QLocalSocket::readyRead, this, [this]() {
+      for (const QJsonObject& wMessage : jobprotocol::read(&mSocket))
+      {
+        onMessage(wMessage);
+      }
+      });
+    connect(&mSocket, &QLocalSocket::disconnected, this, [this]() {
+      Event wEvent;
+      wEvent.mType = Event::Type::Disconnected;
+      post(std::move(wEvent));
+      });
+  }
+
+  bool connectToDaemon(const QString& program)
+  {
+    mSocket.connectToServer(jobprotocol::serverName());
+    if (mSocket.waitForConnected(300))
+    {
+      return true;
+    }
+
+    if (!QProcess::startDetached(program, { "--job-daemon" }))
+    {
+      return false;
+    }
+
+    // only on the first start of the session, the daemon is up in a moment
+    for (int i = 0; i < 20; ++i)
+    {
+      QThread::msleep(100);
+      mSocket.connectToServer(jobprotocol::serverName());
+      if (mSocket.waitForConnected(100))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void write(const QJsonObject& message)
+  {
+    if (mSocket.state() == QLocalSocket::ConnectedState)
+    {
+      jobprotocol::write(&mSocket, message);
+    }
+  }
+
+  void close()
+  {
+    mSocket.disconnect(this);
+    mSocket.flush();
+    mSocket.disconnectFromServer(); // the jobs are left to the daemon
+  }
+
+  SpscQueue<Event, 256> mEvents;
+
+private:
+  void onMessage(const QJsonObject& message)
+  {
+    static const std::map<QString, Event::Type> sTypes = { { "accepted", Event::Type::Accepted },
+                                                           { "refused", Event::Type::Refused },
+                                                           { "started", Event::Type::Started },
+                                                           { "progress", Event::Type::Progress },
+                                                           { "rejected", Event::Type::Rejected },
+                                                           { "finished", Event::Type::Finished },
+                                                           { "limits", Event::Type::Limits } };
+    auto wType = sTypes.find(message.value("ev").toString());
+    if (wType == sTypes.end())
+    {
+      return;
+    }
+
+    Event wEvent;
+    wEvent.mType = wType->second;
+    wEvent.mId = static_cast<Job::Id>(message.value("id").toInteger());
+    wEvent.mTag = static_cast<Job::Id>(message.value("tag").toInteger());
+    wEvent.mTime = VTime(message.value("ms").toInteger());
+    wEvent.mSucceeded = message.value("ok").toBool();
+    wEvent.mReason = message.value("reason").toString();
+    if (wEvent.mType == Event::Type::Limits)
+    {
+      wEvent.mLimits = jobprotocol::limitsFromJson(message.value("limits").toObject());
+    }
+    post(std::move(wEvent));
+  }
+
+  void post(Event&& event)
+  {
+    if (!mEvents.pushOrKeep(std::move(event)))
+    {
+      scheduleFlush(); // the ui is behind
+    }
+  }
+
+  void scheduleFlush()
+  {
+    if (mFlushPending)
+    {
+      return;
+    }
+    mFlushPending = true;
+    QTimer::singleShot(sFlushIntervalMs, this, [this]() {
+      mFlushPending = false;
+      if (!mEvents.flush())
+      {
+        scheduleFlush();
+      }
+      });
+  }
+
+  QLocalSocket mSocket{ this }; // a child, it moves to the i/o thread with the connection
+  bool mFlushPending = false;
+
+  static constexpr int sFlushIntervalMs = 16;
+};
+
+JobClient::JobClient(QObject* parent)
+  : JobQueue(parent)
+  , mConnection(new Connection)
+{
+  mIoThread.setObjectName("JobClient");
+  mConnection->moveToThread(&mIoThread);
+  mIoThread.start();
+
+  connect(&mDrainTimer, &QTimer::timeout, this, &JobClient::drainEvents);
+}
+
+JobClient::~JobClient()
+{
+  Connection* wConnection = mConnection;
+  QMetaObject::invokeMethod(wConnection, [wConnection]() { wConnection->close(); }, Qt::BlockingQueuedConnection);
+  mIoThread.quit();
+  mIoThread.wait();
+  delete mConnection;
+}
+
+bool JobClient::connectToDaemon(const QString& program)
+{
+  // the socket belongs to the i/o thread, wait for it there
+  Connection* wConnection = mConnection;
+  QMetaObject::invokeMethod(wConnection, [wConnection, program]() {
+    return wConnection->connectToDaemon(program);
+    }, Qt::BlockingQueuedConnection, qReturnArg(mConnected));
+
+  mProgram = program;
+  updateDrainInterval();
+  return mConnected;
+}
+
+Job::Id JobClient::submit(const Job& job)
+{
+  const Job::Id wId = ++mLastId;
+  if (!mConnected)
+  {
+    mWaiting.emplace(wId, job);
+    reconnect();
+    return wId;
+  }
+
+  sendJob(wId, job);
+  return wId;
+}
+
+void JobClient::sendJob(const Job::Id id, const Job& job)
+{
+  mUnfinished.insert(id);
+  updateDrainInterval();
+  send([job, id]() {
+    return QJsonObject{ { "op", "submit" }, { "tag", static_cast<qint64>(id) }, { "job", jobprotocol::toJson(job) } };
+    });
+}
+
+void JobClient::cancel(const Job::Id id)
+{
+  if (mWaiting.erase(id) > 0)
+  {
+    QMetaObject::invokeMethod(this, [this, id]() { emit jobFinished(id, false); }, Qt::QueuedConnection);
+    return;
+  }
+  auto wIt = mDaemonIds.find(id);
+  if (wIt == mDaemonIds.end())
+  {
+    mCancelRequested.insert(id); // sent when the daemon accepted it
+    return;
+  }
+  const qint64 wDaemonId = static_cast<qint64>(wIt->second);
+  send([wDaemonId]() { return QJsonObject{ { "op", "cancel" }, { "id", wDaemonId } }; });
+}
+
+void JobClient::promote(const Job::Id id)
+{
+  auto wIt = mDaemonIds.find(id);
+  if (wIt == mDaemonIds.end())
+  {
+    mPromoteRequested.insert(id); // sent when the daemon accepted it
+    return;
+  }
+  const qint64 wDaemonId = static_cast<qint64>(wIt->second);
+  send([wDaemonId]() { return QJsonObject{ { "op", "promote" }, { "id", wDaemonId } }; });
+}
+
+void JobClient::setMaxRunning(const unsigned maxRunning)
+{
+  mMaxRunning = maxRunning;
+  sendConfig();
+}
+
+void JobClient::setMaxReadersPerDevice(const unsigned maxReaders)
+{
+  mMaxReaders = maxReaders;
+  sendConfig();
+}
+
+void JobClient::setMaxWritersPerDevice(const unsigned maxWriters)
+{
+  mMaxWriters = maxWriters;
+  sendConfig();
+}
+
+unsigned JobClient::maxRunning() const
+{
+  return mMaxRunning;
+}
+
+void JobClient::setThreadBudget(const unsigned threads)
+{
+  mThreadBudget = threads;
+  sendConfig();
+}
+
+void JobClient::setRunningLimit(const unsigned limit)
+{
+  mRunningLimit = limit;
+  sendThrottle();
+}
+
+void JobClient::setBulkPaused(const bool paused)
+{
+  mBulkPaused = paused;
+  sendThrottle();
+}
+
+void JobClient::setBackground(const bool background)
+{
+  mBackground = background;
+  sendThrottle();
+}
+
+std::map<QString, int> JobClient::learnedDeviceLimits() const
+{
+  return mLearnedLimits;
+}
+
+void JobClient::setLearnedDeviceLimits(const std::map<QString, int>& limits)
+{
+  mLearnedLimits = limits;
+  sendConfig();
+}
+
+void JobClient::drainEvents()
+{
+  // the daemon already sends the progress only a few times a second, nothing to coalesce here
+  Event wEvent;
+  while (mConnection->mEvents.pop(wEvent))
+  {
+    onEvent(wEvent);
+  }
+}
+
+void JobClient::onEvent(Event& event)
+{
+  if (event.mType == Event::Type::Accepted)
+  {
+    mLocalIds[event.mId] = event.mTag;
+    mDaemonIds[event.mTag] = event.mId;
+    if (mCancelRequested.erase(event.mTag) > 0)
+    {
+      cancel(event.mTag);
+    }
+    else if (mPromoteRequested.erase(event.mTag) > 0)
+    {
+      promote(event.mTag);
+    }
+    return;
+  }
+  if (event.mType == Event::Type::Refused)
+  {
+    // never got a daemon id, it ends here
+    mCancelRequested.erase(event.mTag);
+    mPromoteRequested.erase(event.mTag);
+    mUnfinished.erase(event.mTag);
+    updateDrainInterval();
+    emit jobRejected(event.mTag, event.mReason);
+    emit jobFinished(event.mTag, false);
+    return;
+  }
+  if (event.mType == Event::Type::Limits)
+  {
+    mLearnedLimits = std::move(event.mLimits);
+    emit deviceLimitsLearned();
+    return;
+  }
+  if (event.mType == Event::Type::Disconnected)
+  {
+    onDisconnected();
+    return;
+  }
+
+  auto wIt = mLocalIds.find(event.mId);
+  if (wIt == mLocalIds.end())
+  {
+    return; // not ours
+  }
+
+  const Job::Id wId = wIt->second;
+  switch (event.mType)
+  {
+    case Event::Type::Started:
+      emit jobStarted(wId);
+      break;
+    case Event::Type::Progress:
+      emit jobProgress(wId, event.mTime);
+      break;
+    case Event::Type::Rejected:
+      emit jobRejected(wId, event.mReason);
+      break;
+    case Event::Type::Finished:
+      mUnfinished.erase(wId);
+      mDaemonIds.erase(wId);
+      mLocalIds.erase(wIt);
+      updateDrainInterval();
+      emit jobFinished(wId, event.mSucceeded);
+      break;
+    default:
+      break;
+  }
+}
+
+void JobClient::onDisconnected()
+{
+  // the daemon is gone with the jobs, nothing will report about them anymore
+  mConnected = false;
+  const std::set<Job::Id> wUnfinished = std::move(mUnfinished);
+  mUnfinished.clear();
+  mLocalIds.clear();
+  mDaemonIds.clear();
+  updateDrainInterval();
+  for (const Job::Id wId : wUnfinished)
+  {
+    emit jobFinished(wId, false);
+  }
+  reconnect(); // the next jobs go to a new daemon
+}
+
+void JobClient::reconnect()
+{
+  if (mReconnecting || mProgram.isEmpty())
+  {
+    return;
+  }
+  mReconnecting = true;
+
+  // the wait for the new daemon blocks the i/o thread only, the answer comes back through the event loop
+  Connection* wConnection = mConnection;
+  const QString wProgram = mProgram;
+  QMetaObject::invokeMethod(wConnection, [this, wConnection, wProgram]() {
+    const bool wConnected = wConnection->connectToDaemon(wProgram);
+    QMetaObject::invokeMethod(this, [this, wConnected]() { onReconnected(wConnected); }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void JobClient::onReconnected(const bool connected)
+{
+  mReconnecting = false;
+  mConnected = connected;
+  std::map<Job::Id, Job> wWaiting = std::move(mWaiting);
+  mWaiting.clear();
+  if (!connected)
+  {
+    // no daemon to run them, the next submit tries again
+    for (const auto& wEntry : wWaiting)
+    {
+      emit jobFinished(wEntry.first, false);
+    }
+    return;
+  }
+
+  // a new daemon knows nothing about this window
+  sendConfig();
+  sendThrottle();
+  for (const auto& wEntry : wWaiting)
+  {
+    sendJob(wEntry.first, wEntry.second);
+  }
+  updateDrainInterval();
+}
+
+void JobClient::send(std::function<QJsonObject()> message)
+{
+  Connection* wConnection = mConnection;
+  QMetaObject::invokeMethod(wConnection, [wConnection, message]() { wConnection->write(message()); }, Qt::QueuedConnection);
+}
+
+void JobClient::sendConfig()
+{
+  const int wMaxRunning = static_cast<int>(mMaxRunning);
+  const int wReaders = static_cast<int>(mMaxReaders);
+  const int wWriters = static_cast<int>(mMaxWriters);
+  const int wThreads = static_cast<int>(mThreadBudget);
+  const std::map<QString, int> wLimits = mLearnedLimits;
+  send([wMaxRunning, wReaders, wWriters, wThreads, wLimits]() {
+    return QJsonObject{ { "op", "config" },
+                        { "maxRunning", wMaxRunning },
+                        { "readers", wReaders },
+                        { "writers", wWriters },
+                        { "threads", wThreads },
+                        { "limits", jobprotocol::toJson(wLimits) } };
+    });
+}
+
+void JobClient::sendThrottle()
+{
+  const qint64 wLimit = static_cast<qint64>(mRunningLimit);
+  const bool wBulkPaused = mBulkPaused;
+  const bool wBackground = mBackground;
+  send([wLimit, wBulkPaused, wBackground]() {
+    return QJsonObject{ { "op", "throttle" }, { "limit", wLimit }, { "bulkPaused", wBulkPaused }, { "background", wBackground } };
+    });
+}
+
+void JobClient::updateDrainInterval()
+{
+  if (!mConnected)
+  {
+    mDrainTimer.stop();
+    return;
+  }
+  const int wInterval = mUnfinished.empty() ? sIdleDrainIntervalMs : sDrainIntervalMs;
+  if (!mDrainTimer.isActive() || mDrainTimer.interval() != wInterval)
+  {
+    mDrainTimer.start(wInterval);
+  }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "JobQueue.h"
+
+#include <QJsonObject>
+#include <QThread>
+#include <QTimer>
+
+#include <functional>
+#include <limits>
+#include <map>
+#include <set>
+
+// the jobs are run by the job daemon, see JobDaemon, the ids are local to this client
+// the socket is served on an i/o thread, the messages are parsed there and handed over through a lock-free queue,
+// this thread only takes the decoded records, once per frame while jobs are running
+class JobClient : public JobQueue
+{
+  Q_OBJECT
+
+public:
+  JobClient(QObject* parent = nullptr);
+  ~JobClient();
+
+  // starts the daemon with the given program if none is running yet, and again when it goes away:
+  // the jobs submitted meanwhile wait for the new daemon, the ones it took with it have failed
+  bool connectToDaemon(const QString& program);
+
+  Job::Id submit(const Job& job) override;
+  void cancel(const Job::Id id) override;
+  void promote(const Job::Id id) override;
+
+  void setMaxRunning(const unsigned maxRunning) override;
+  void setMaxReadersPerDevice(const unsigned maxReaders) override;
+  void setMaxWritersPerDevice(const unsigned maxWriters) override;
+  unsigned maxRunning() const override;
+  void setThreadBudget(const unsigned threads) override;
+
+  void setRunningLimit(const unsigned limit) override;
+  void setBulkPaused(const bool paused) override;
+  void setBackground(const bool background) override;
+
+  std::map<QString, int> learnedDeviceLimits() const override;
+  void setLearnedDeviceLimits(const std::map<QString, int>& limits) override;
+
+private:
+  class Connection;
+  struct Event;
+
+  void drainEvents();
+  void onEvent(Event& event);
+  void onDisconnected();
+  void reconnect();
+  void onReconnected(const bool connected);
+  void sendJob(const Job::Id id, const Job& job);
+  void send(std::function<QJsonObject()> message); // the message is built and written on the i/o thread
+  void sendConfig();
+  void sendThrottle();
+  void updateDrainInterval();
+
+  QThread mIoThread;
+  Connection* mConnection = nullptr; // lives on mIoThread
+  bool mConnected = false;
+  QString mProgram;
+  bool mReconnecting = false;
+  std::map<Job::Id, Job> mWaiting; // local ids, submitted while the daemon was away
+  QTimer mDrainTimer;
+
+  Job::Id mLastId = 0;
+  std::map<Job::Id, Job::Id> mLocalIds;  // by daemon id
+  std::map<Job::Id, Job::Id> mDaemonIds; // by local id
+  std::set<Job::Id> mUnfinished;         // local ids
+  std::set<Job::Id> mCancelRequested;    // local ids not accepted yet
+  std::set<Job::Id> mPromoteRequested;   // local ids not accepted yet
+
+  unsigned mMaxRunning = 4;
+  unsigned mMaxReaders = 2;
+  unsigned mMaxWriters = 2;
+  unsigned mThreadBudget = 0;
+  std::map<QString, int> mLearnedLimits;
+
+  unsigned mRunningLimit = std::numeric_limits<unsigned>::max();
+  bool mBulkPaused = false;
+  bool mBackground = false;
+
+  static constexpr int sDrainIntervalMs = 16;  // a frame at 60 Hz
+  static constexpr int sIdleDrainIntervalMs = 250; // no job of ours, only limits and the disconnect can come
+};
@@ -0,0 +1,302 @@
+#include "JobDaemon.h"
+#include "JobProtocol.h"
+#include "Utils.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace
+{
+
+QString dataDirectory()
+{
+  const QString wDirectory = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+  QDir().mkpath(wDirectory);
+  return wDirectory;
+}
+
+}
+
+JobDaemon::JobDaemon(QObject* parent)
+  : QObject(parent)
+  , mLock(dataDirectory() + "/jobs.lock")
+  , mJournal(dataDirectory() + "/jobs.journal")
+{
+  mClock.start();
+  mIdleTimer.setSingleShot(true);
+  mIdleTimer.setInterval(sIdleTimeoutMs);
+  connect(&mIdleTimer, &QTimer::timeout, this, []() { QCoreApplication::quit(); });
+
+  connect(&mServer, &QLocalServer::newConnection, this, &JobDaemon::onConnection);
+
+  connect(&mScheduler, &JobQueue::jobStarted, this, [this](Job::Id id) {
+    journal({ { "op", "started" }, { "id", static_cast<qint64>(id) } });
+    sendToOwner(id, { { "ev", "started" }, { "id", static_cast<qint64>(id) } });
+  });
+  connect(&mScheduler, &JobQueue::jobProgress, this, [this](Job::Id id, VTime time) {
+    qint64& wLast = mLastProgress[id];
+    if (mClock.elapsed() - wLast < sProgressIntervalMs)
+    {
+      return;
+    }
+    wLast = mClock.elapsed();
+    sendToOwner(id, { { "ev", "progress" }, { "id", static_cast<qint64>(id) }, { "ms", time.ms() } });
+  });
+  connect(&mScheduler, &JobQueue::jobRejected, this, [this](Job::Id id, const QString& reason) {
+    sendToOwner(id, { { "ev", "rejected" }, { "id", static_cast<qint64>(id) }, { "reason", reason } });
+  });
+  connect(&mScheduler, &JobQueue::jobFinished, this, [this](Job::Id id, bool succeeded) {
+    journal({ { "op", "done" }, { "id", static_cast<qint64>(id) } });
+    sendToOwner(id, { { "ev", "finished" }, { "id", static_cast<qint64>(id) }, { "ok", succeeded } });
+    mOwners.erase(id);
+    mLastProgress.erase(id);
+    mSpeculative.erase(id);
+    checkIdle();
+  });
+  connect(&mScheduler, &JobQueue::deviceLimitsLearned, this, [this]() {
+    const QJsonObject wMessage{ { "ev", "limits" }, { "limits", jobprotocol::toJson(mScheduler.learnedDeviceLimits()) } };
+    for (const auto& wClient : mClients)
+    {
+      jobprotocol::write(wClient.first, wMessage);
+    }
+  });
+}
+
+JobDaemon::~JobDaemon()
+{
+  mServer.close();
+}
+
+bool JobDaemon::start()
+{
+  if (!mLock.tryLock(0))
+  {
+    return false;
+  }
+
+  QLocalServer::removeServer(jobprotocol::serverName()); // a crashed daemon may have left it behind
+  if (!mServer.listen(jobprotocol::serverName()))
+  {
+    return false;
+  }
+
+  replayJournal();
+  checkIdle();
+  return true;
+}
+
+void JobDaemon::onConnection()
+{
+  while (QLocalSocket* wSocket = mServer.nextPendingConnection())
+  {
+    mClients[wSocket] = Client();
+    mIdleTimer.stop();
+
+    connect(wSocket, &QLocalSocket::readyRead, this, [this, wSocket]() {
+      for (const QJsonObject& wMessage : jobprotocol::read(wSocket))
+      {
+        onMessage(wSocket, wMessage);
+      }
+    });
+    connect(wSocket, &QLocalSocket::disconnected, this, [this, wSocket]() { onDisconnected(wSocket); });
+  }
+}
+
+void JobDaemon::onMessage(QLocalSocket* socket, const QJsonObject& message)
+{
+  const QString wOp = message.value("op").toString();
+  if (wOp == "submit")
+  {
+    const Job wJob = jobprotocol::jobFromJson(message.value("job").toObject());
+    if (!isAllowed(wJob))
+    {
+      jobprotocol::write(socket, { { "ev", "refused" }, { "tag", message.value("tag") }, { "reason", "not a tool of the player: " + wJob.mProgram } });
+      return;
+    }
+    const Job::Id wId = submit(wJob, socket);
+    jobprotocol::write(socket, { { "ev", "accepted" }, { "tag", message.value("tag") }, { "id", static_cast<qint64>(wId) } });
+  }
+  else if (wOp == "cancel")
+  {
+    const Job::Id wId = static_cast<Job::Id>(message.value("id").toInteger());
+    if (isOwner(wId, socket))
+    {
+      mScheduler.cancel(wId);
+    }
+  }
+  else if (wOp == "promote")
+  {
+    const Job::Id wId = static_cast<Job::Id>(message.value("id").toInteger());
+    if (isOwner(wId, socket))
+    {
+      mSpeculative.erase(wId);
+      mScheduler.promote(wId);
+    }
+  }
+  else if (wOp == "config")
+  {
+    // the windows share the limits, the last one configuring wins
+    mScheduler.setMaxRunning(message.value("maxRunning").toInt(4));
+    mScheduler.setMaxReadersPerDevice(message.value("readers").toInt(2));
+    mScheduler.setMaxWritersPerDevice(message.value("writers").toInt(2));
+    mScheduler.setThreadBudget(message.value("threads").toInt(0));
+    mScheduler.setLearnedDeviceLimits(jobprotocol::limitsFromJson(message.value("limits").toObject()));
+  }
+  else if (wOp == "throttle")
+  {
+    Client& wClient = mClients[socket];
+    wClient.mRunningLimit = static_cast<unsigned>(message.value("limit").toInteger(std::numeric_limits<unsigned>::max()));
+    wClient.mBulkPaused = message.value("bulkPaused").toBool();
+    wClient.mBackground = message.value("background").toBool();
+    applyThrottle();
+  }
+}
+
+void JobDaemon::onDisconnected(QLocalSocket* socket)
+{
+  // the jobs of the window keep running, their events have nowhere to go, only the speculative ones are dropped
+  mClients.erase(socket);
+  std::vector<Job::Id> wDropped;
+  for (auto& wOwner : mOwners)
+  {
+    if (wOwner.second == socket)
+    {
+      wOwner.second = nullptr;
+      if (mSpeculative.count(wOwner.first) > 0)
+      {
+        wDropped.push_back(wOwner.first);
+      }
+    }
+  }
+  for (const Job::Id wId : wDropped)
+  {
+    mScheduler.cancel(wId); // may finish right away, which changes the owners
+  }
+  socket->deleteLater();
+
+  applyThrottle();
+  checkIdle();
+}
+
+void JobDaemon::sendToOwner(const Job::Id id, const QJsonObject& message)
+{
+  auto wIt = mOwners.find(id);
+  if (wIt != mOwners.end() && wIt->second != nullptr)
+  {
+    jobprotocol::write(wIt->second, message);
+  }
+}
+
+void JobDaemon::applyThrottle()
+{
+  // the most demanding playback of all the windows decides
+  unsigned wLimit = std::numeric_limits<unsigned>::max();
+  bool wBulkPaused = false;
+  bool wBackground = false;
+  for (const auto& wClient : mClients)
+  {
+    wLimit = std::min(wLimit, wClient.second.mRunningLimit);
+    wBulkPaused = wBulkPaused || wClient.second.mBulkPaused;
+    wBackground = wBackground || wClient.second.mBackground;
+  }
+  mScheduler.setRunningLimit(wLimit);
+  mScheduler.setBulkPaused(wBulkPaused);
+  mScheduler.setBackground(wBackground);
+}
+
+void JobDaemon::checkIdle()
+{
+  if (mClients.empty() && mScheduler.pendingCount() == 0 && mScheduler.runningCount() == 0)
+  {
+    mIdleTimer.start();
+  }
+}
+
+bool JobDaemon::isAllowed(const Job& job)
+{
+  // any local process can connect, the socket must not run arbitrary programs
+  const QString wProgram = QDir::cleanPath(QFileInfo(job.mProgram).absoluteFilePath());
+  for (const QString& wTool : { utils::ffmpegPath(), utils::ffprobePath() })
+  {
+    if (wProgram.compare(QDir::cleanPath(QFileInfo(wTool).absoluteFilePath()), Qt::CaseInsensitive) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool JobDaemon::isOwner(const Job::Id id, QLocalSocket* socket) const
+{
+  auto wIt = mOwners.find(id);
+  return wIt != mOwners.end() && wIt->second == socket;
+}
+
+Job::Id JobDaemon::submit(const Job& job, QLocalSocket* owner)
+{
+  const Job::Id wId = mScheduler.submit(job);
+  mOwners[wId] = owner;
+  if (job.mSpeculative)
+  {
+    mSpeculative.insert(wId);
+  }
+  journal({ { "op", "submit" }, { "id", static_cast<qint64>(wId) }, { "job", jobprotocol::toJson(job) } });
+  return wId;
+}
+
+void JobDaemon::journal(const QJsonObject& record)
+{
+  if (!mJournal.isOpen())
+  {
+    return;
+  }
+  mJournal.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n');
+  mJournal.flush(); // it has to survive a crash of the daemon
+}
+
+void JobDaemon::replayJournal()
+{
+  // the jobs submitted but not done, in submission order
+  std::vector<std::pair<qint64, Job>> wOpenJobs;
+  if (mJournal.open(QIODevice::ReadOnly))
+  {
+    std::set<qint64> wDone;
+    std::vector<std::pair<qint64, Job>> wSubmitted;
+    while (!mJournal.atEnd())
+    {
+      const QJsonObject wRecord = QJsonDocument::fromJson(mJournal.readLine()).object();
+      const QString wOp = wRecord.value("op").toString();
+      if (wOp == "submit")
+      {
+        wSubmitted.emplace_back(wRecord.value("id").toInteger(), jobprotocol::jobFromJson(wRecord.value("job").toObject()));
+      }
+      else if (wOp == "done")
+      {
+        wDone.insert(wRecord.value("id").toInteger());
+      }
+    }
+    mJournal.close();
+
+    // speculative work is not worth a restart, its window is gone
+    std::copy_if(wSubmitted.begin(), wSubmitted.end(), std::back_inserter(wOpenJobs), [&wDone](const auto& submitted) {
+      return wDone.count(submitted.first) == 0 && !submitted.second.mSpeculative;
+    });
+  }
+
+  // the journal starts over with the jobs run again, the outputs are overwritten from scratch
+  mJournal.open(QIODevice::WriteOnly | QIODevice::Truncate);
+  for (const auto& wOpenJob : wOpenJobs)
+  {
+    if (isAllowed(wOpenJob.second))
+    {
+      submit(wOpenJob.second, nullptr);
+    }
+  }
+}
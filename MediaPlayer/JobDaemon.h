@@ -0,0 +1,67 @@
+#pragma once
+
+#include "JobScheduler.h"
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLockFile>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+#include <map>
+#include <memory>
+#include <set>
+
+class QLocalSocket;
+
+// owns the encoder jobs of all the player windows, started by the first player as "MediaPlayer --job-daemon"
+// the jobs are journaled, the ones not finished when the daemon went down are run again on its next start
+// only the tools of the player are run, see utils::ffmpegPath, and a job is cancelled or promoted only by the window that submitted it
+// quits when no player is connected and there is nothing left to do
+class JobDaemon : public QObject
+{
+  Q_OBJECT
+
+public:
+  JobDaemon(QObject* parent = nullptr);
+  ~JobDaemon();
+
+  bool start(); // false if an other daemon is running
+
+private:
+  struct Client
+  {
+    unsigned mRunningLimit = std::numeric_limits<unsigned>::max();
+    bool mBulkPaused = false;
+    bool mBackground = false;
+  };
+
+  void onConnection();
+  void onMessage(QLocalSocket* socket, const QJsonObject& message);
+  void onDisconnected(QLocalSocket* socket);
+  void sendToOwner(const Job::Id id, const QJsonObject& message);
+  void applyThrottle();
+  void checkIdle();
+
+  static bool isAllowed(const Job& job);
+  bool isOwner(const Job::Id id, QLocalSocket* socket) const;
+  Job::Id submit(const Job& job, QLocalSocket* owner);
+  void journal(const QJsonObject& record);
+  void replayJournal();
+
+  QLockFile mLock;
+  QLocalServer mServer;
+  JobScheduler mScheduler;
+  std::map<QLocalSocket*, Client> mClients;
+  std::map<Job::Id, QLocalSocket*> mOwners;
+  std::map<Job::Id, qint64> mLastProgress; // progress is sent a few times a second, not on every ffmpeg line
+  std::set<Job::Id> mSpeculative;          // nobody waits for them once their window is gone
+  QFile mJournal;
+  QTimer mIdleTimer;
+  QElapsedTimer mClock;
+
+  static constexpr int sIdleTimeoutMs = 30000;
+  static constexpr qint64 sProgressIntervalMs = 250;
+};
@@ -0,0 +1,90 @@
+#include "JobProtocol.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalSocket>
+
+namespace jobprotocol
+{
+
+QString serverName()
+{
+  // the pipe namespace is shared by the sessions of the machine
+  return "IstuSoft.MediaPlayer.Jobs." + qEnvironmentVariable("USERNAME", "user");
+}
+
+QJsonObject toJson(const Job& job)
+{
+  return QJsonObject{ { "name", job.mName },
+                      { "program", job.mProgram },
+                      { "arguments", QJsonArray::fromStringList(job.mArguments) },
+                      { "source", job.mSourcePath },
+                      { "destination", job.mDestinationPath },
+                      { "duration", job.mDuration.ms() },
+                      { "timeScale", job.mTimeScale },
+                      { "bulk", job.mBulk },
+                      { "speculative", job.mSpeculative },
+                      { "inputBytes", job.mInputBytes },
+                      { "outputBytes", job.mOutputBytes } };
+}
+
+Job jobFromJson(const QJsonObject& object)
+{
+  Job wJob;
+  wJob.mName = object.value("name").toString();
+  wJob.mProgram = object.value("program").toString();
+  for (const QJsonValue& wArgument : object.value("arguments").toArray())
+  {
+    wJob.mArguments.push_back(wArgument.toString());
+  }
+  wJob.mSourcePath = object.value("source").toString();
+  wJob.mDestinationPath = object.value("destination").toString();
+  wJob.mDuration = VTime(object.value("duration").toInteger());
+  wJob.mTimeScale = object.value("timeScale").toDouble(1.0);
+  wJob.mBulk = object.value("bulk").toBool();
+  wJob.mSpeculative = object.value("speculative").toBool();
+  wJob.mInputBytes = object.value("inputBytes").toInteger();
+  wJob.mOutputBytes = object.value("outputBytes").toInteger();
+  return wJob;
+}
+
+QJsonObject toJson(const std::map<QString, int>& limits)
+{
+  QJsonObject wObject;
+  for (const auto& wLimit : limits)
+  {
+    wObject.insert(wLimit.first, wLimit.second);
+  }
+  return wObject;
+}
+
+std::map<QString, int> limitsFromJson(const QJsonObject& object)
+{
+  std::map<QString, int> wLimits;
+  for (auto wIt = object.begin(); wIt != object.end(); ++wIt)
+  {
+    wLimits[wIt.key()] = wIt.value().toInt();
+  }
+  return wLimits;
+}
+
+void write(QLocalSocket* socket, const QJsonObject& message)
+{
+  socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+}
+
+std::vector<QJsonObject> read(QLocalSocket* socket)
+{
+  std::vector<QJsonObject> wMessages;
+  while (socket->canReadLine())
+  {
+    const QJsonDocument wDocument = QJsonDocument::fromJson(socket->readLine());
+    if (wDocument.isObject())
+    {
+      wMessages.push_back(wDocument.object());
+    }
+  }
+  return wMessages;
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "JobQueue.h"
+
+#include <QJsonObject>
+#include <QString>
+
+#include <map>
+#include <vector>
+
+class QLocalSocket;
+
+// messages between the players and the job daemon, one compact json object per line
+//   player -> daemon: submit, cancel, promote, config, throttle
+//   daemon -> player: accepted, refused, started, progress, finished, rejected, limits
+namespace jobprotocol
+{
+
+QString serverName();
+
+QJsonObject toJson(const Job& job);
+Job jobFromJson(const QJsonObject& object);
+
+QJsonObject toJson(const std::map<QString, int>& limits);
+std::map<QString, int> limitsFromJson(const QJsonObject& object);
+
+void write(QLocalSocket* socket, const QJsonObject& message);
+std::vector<QJsonObject> read(QLocalSocket* socket); // the complete lines received so far
+
+}
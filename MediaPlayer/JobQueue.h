@@ -0,0 +1,65 @@
+#pragma once
+
+#include "VTime.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <map>
+
+// an encoder process to run, see JobQueue
+struct Job
+{
+  using Id = quint64;
+
+  // argument replaced by the thread share of the job when it starts, jobs without it are not counted in the budget
+  static constexpr const char* sThreadCount = "%threads%";
+
+  QString mName;             // for the status messages
+  QString mProgram;
+  QStringList mArguments;
+  QString mSourcePath;       // the devices of these paths limit the concurrency
+  QString mDestinationPath;
+  VTime mDuration;           // source time covered by the job, progress is capped to it
+  double mTimeScale = 1.0;   // output time * time scale = source time
+  bool mBulk = false;        // batch work, held back first when playback needs the machine
+  bool mSpeculative = false; // work nobody asked for yet, runs at idle priority while no other job waits or runs
+  qint64 mInputBytes = 0;    // estimates, 0 is unknown
+  qint64 mOutputBytes = 0;   // checked against the free space of the destination
+};
+
+// where the jobs go, the scheduler in this process (JobScheduler) or the one of the job daemon (JobClient)
+class JobQueue : public QObject
+{
+  Q_OBJECT
+
+public:
+  using QObject::QObject;
+  virtual ~JobQueue() = default;
+
+  virtual Job::Id submit(const Job& job) = 0;
+  virtual void cancel(const Job::Id id) = 0;
+  virtual void promote(const Job::Id id) = 0; // a speculative job becomes a normal one, it keeps its progress
+
+  virtual void setMaxRunning(const unsigned maxRunning) = 0;
+  virtual void setMaxReadersPerDevice(const unsigned maxReaders) = 0;
+  virtual void setMaxWritersPerDevice(const unsigned maxWriters) = 0;
+  virtual unsigned maxRunning() const = 0;
+  virtual void setThreadBudget(const unsigned threads) = 0;
+
+  // throttling, see QosController
+  virtual void setRunningLimit(const unsigned limit) = 0;
+  virtual void setBulkPaused(const bool paused) = 0;
+  virtual void setBackground(const bool background) = 0;
+
+  virtual std::map<QString, int> learnedDeviceLimits() const = 0;
+  virtual void setLearnedDeviceLimits(const std::map<QString, int>& limits) = 0;
+
+signals:
+  void jobStarted(Job::Id id);
+  void jobProgress(Job::Id id, VTime time); // processed source time
+  void jobFinished(Job::Id id, bool succeeded);
+  void jobRejected(Job::Id id, const QString& reason); // followed by jobFinished
+  void deviceLimitsLearned();
+};
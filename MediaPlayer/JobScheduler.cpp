@@ -0,0 +1,534 @@
+#include "JobScheduler.h"
+
+#include <QFile>
+#include <QThread>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#include <tlhelp32.h>
+#else
+#include <signal.h>
+#endif
+
+JobScheduler::JobScheduler(QObject* parent)
+  : JobQueue(parent)
+{
+  // runs only while there are jobs running, an idle scheduler wakes up nobody
+  mDrainTimer.setInterval(sDrainIntervalMs);
+  connect(&mDrainTimer, &QTimer::timeout, this, &JobScheduler::drainEvents);
+}
+
+JobScheduler::~JobScheduler()
+{
+  mIo.killAll();
+  for (const auto& wRunning : mRunning)
+  {
+    if (wRunning.second.mJob.mSpeculative)
+    {
+      QFile::remove(wRunning.second.mJob.mDestinationPath);
+    }
+  }
+}
+
+Job::Id JobScheduler::submit(const Job& job)
+{
+  Entry wEntry;
+  wEntry.mId = ++mLastId;
+  wEntry.mJob = job;
+  wEntry.mSourceDevice = mDevices.deviceOf(job.mSourcePath);
+  wEntry.mDestinationDevice = mDevices.deviceOf(job.mDestinationPath);
+  mPending.push_back(std::move(wEntry));
+
+  // the caller gets the id before any signal of the job is emitted
+  QMetaObject::invokeMethod(this, &JobScheduler::schedule, Qt::QueuedConnection);
+  return mLastId;
+}
+
+void JobScheduler::cancel(const Job::Id id)
+{
+  auto wPendingIt = std::find_if(mPending.begin(), mPending.end(), [id](const Entry& entry) { return entry.mId == id; });
+  if (wPendingIt != mPending.end())
+  {
+    mPending.erase(wPendingIt);
+    emit jobFinished(id, false);
+    return;
+  }
+
+  auto wRunningIt = mRunning.find(id);
+  if (wRunningIt != mRunning.end())
+  {
+    wRunningIt->second.mPreempted = false; // it is not queued again
+    mIo.kill(id); // finished comes with the events of the process
+  }
+}
+
+void JobScheduler::promote(const Job::Id id)
+{
+  auto wPendingIt = std::find_if(mPending.begin(), mPending.end(), [id](const Entry& entry) { return entry.mId == id; });
+  if (wPendingIt != mPending.end())
+  {
+    wPendingIt->mJob.mSpeculative = false;
+    schedule();
+    return;
+  }
+
+  // a preempted one is queued again as a real job once its process is gone
+  auto wRunningIt = mRunning.find(id);
+  if (wRunningIt != mRunning.end())
+  {
+    wRunningIt->second.mJob.mSpeculative = false;
+    applyPriority(wRunningIt->second);
+  }
+}
+
+void JobScheduler::setMaxRunning(const unsigned maxRunning)
+{
+  mMaxRunning = std::max(1u, maxRunning);
+  schedule();
+}
+
+void JobScheduler::setMaxReadersPerDevice(const unsigned maxReaders)
+{
+  mDevices.setDefaultReaderLimit(maxReaders);
+  schedule();
+}
+
+void JobScheduler::setMaxWritersPerDevice(const unsigned maxWriters)
+{
+  mMaxWritersPerDevice = std::max(1u, maxWriters);
+  schedule();
+}
+
+unsigned JobScheduler::maxRunning() const
+{
+  return mMaxRunning;
+}
+
+void JobScheduler::setThreadBudget(const unsigned threads)
+{
+  mThreadBudget = threads; // the running jobs keep their threads, the new ones get the new shares
+}
+
+void JobScheduler::setRunningLimit(const unsigned limit)
+{
+  mRunningLimit = std::max(1u, limit);
+  schedule(); // the jobs above the limit are suspended there
+}
+
+void JobScheduler::setBulkPaused(const bool paused)
+{
+  mBulkPaused = paused;
+  schedule();
+}
+
+void JobScheduler::setBackground(const bool background)
+{
+  if (mBackground == background)
+  {
+    return;
+  }
+
+  mBackground = background;
+  for (const auto& wRunning : mRunning)
+  {
+    applyPriority(wRunning.second);
+  }
+}
+
+size_t JobScheduler::pendingCount() const
+{
+  return mPending.size();
+}
+
+size_t JobScheduler::runningCount() const
+{
+  return mRunning.size();
+}
+
+unsigned JobScheduler::usedThreads() const
+{
+  unsigned wThreads = 0;
+  for (const auto& wRunning : mRunning)
+  {
+    wThreads += wRunning.second.mThreads;
+  }
+  return wThreads;
+}
+
+std::map<QString, int> JobScheduler::learnedDeviceLimits() const
+{
+  return mDevices.learnedLimits();
+}
+
+void JobScheduler::setLearnedDeviceLimits(const std::map<QString, int>& limits)
+{
+  mDevices.setLearnedLimits(limits);
+  schedule();
+}
+
+void JobScheduler::schedule()
+{
+  // real work does not wait for speculative work
+  if (hasRealWork())
+  {
+    for (auto& wRunning : mRunning)
+    {
+      if (wRunning.second.mJob.mSpeculative && !wRunning.second.mPreempted)
+      {
+        wRunning.second.mPreempted = true;
+        mIo.kill(wRunning.first);
+      }
+    }
+  }
+
+  shedLoad();
+
+  // first come first served, but a job waiting for a busy disk does not hold back the jobs of the other disks
+  std::vector<std::pair<Job::Id, QString>> wRejected;
+  auto wIt = mPending.begin();
+  while (wIt != mPending.end() && activeCount() < std::min(mMaxRunning, mRunningLimit))
+  {
+    const Admission wAdmission = admission(*wIt);
+    if (wAdmission == Admission::Wait)
+    {
+      ++wIt;
+      continue;
+    }
+    if (wAdmission == Admission::Never)
+    {
+      wRejected.emplace_back(wIt->mId, QString("not enough free space for %1").arg(wIt->mJob.mDestinationPath));
+      wIt = mPending.erase(wIt);
+      continue;
+    }
+
+    Entry wEntry = std::move(*wIt);
+    wIt = mPending.erase(wIt);
+    start(std::move(wEntry));
+  }
+
+  for (const auto& wRejection : wRejected)
+  {
+    emit jobRejected(wRejection.first, wRejection.second);
+    emit jobFinished(wRejection.first, false);
+  }
+}
+
+void JobScheduler::shedLoad()
+{
+  // a lower limit does nothing for the encoders already running, they are held where they are instead of killed,
+  // the bulk ones first, then the newest
+  std::vector<Entry*> wActive;
+  std::vector<Entry*> wSuspended;
+  for (auto& wRunning : mRunning)
+  {
+    Entry& wEntry = wRunning.second;
+    if (wEntry.mProcessId == 0 || wEntry.mPreempted)
+    {
+      continue; // not started yet, or going away
+    }
+    (wEntry.mSuspended ? wSuspended : wActive).push_back(&wEntry);
+  }
+  auto wHeldFirst = [](const Entry* lhs, const Entry* rhs) {
+    return lhs->mJob.mBulk != rhs->mJob.mBulk ? lhs->mJob.mBulk : lhs->mId > rhs->mId;
+  };
+
+  const unsigned wLimit = std::min(mMaxRunning, mRunningLimit);
+  size_t wActiveCount = activeCount();
+  std::sort(wActive.begin(), wActive.end(), wHeldFirst);
+  for (Entry* wEntry : wActive)
+  {
+    if (wActiveCount > wLimit || (mBulkPaused && wEntry->mJob.mBulk))
+    {
+      setSuspended(*wEntry, true);
+      --wActiveCount;
+    }
+  }
+
+  // the oldest real work goes on first
+  std::sort(wSuspended.begin(), wSuspended.end(), [&wHeldFirst](const Entry* lhs, const Entry* rhs) { return wHeldFirst(rhs, lhs); });
+  for (Entry* wEntry : wSuspended)
+  {
+    if (wActiveCount < wLimit && !(mBulkPaused && wEntry->mJob.mBulk))
+    {
+      setSuspended(*wEntry, false);
+      ++wActiveCount;
+    }
+  }
+}
+
+size_t JobScheduler::activeCount() const
+{
+  return std::count_if(mRunning.begin(), mRunning.end(), [](const auto& running) { return !running.second.mSuspended; });
+}
+
+void JobScheduler::setSuspended(Entry& entry, const bool suspended)
+{
+  entry.mSuspended = suspended;
+  entry.mInterrupted = entry.mInterrupted || suspended;
+
+#ifdef Q_OS_WIN
+  // every thread of the process, ffmpeg creates its workers at the start
+  HANDLE wSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+  if (wSnapshot == INVALID_HANDLE_VALUE)
+  {
+    return;
+  }
+  THREADENTRY32 wThread;
+  wThread.dwSize = sizeof(wThread);
+  for (BOOL wMore = Thread32First(wSnapshot, &wThread); wMore; wMore = Thread32Next(wSnapshot, &wThread))
+  {
+    if (wThread.th32OwnerProcessID != static_cast<DWORD>(entry.mProcessId))
+    {
+      continue;
+    }
+    HANDLE wHandle = OpenThread(THREAD_SUSPEND_RESUME, FALSE, wThread.th32ThreadID);
+    if (wHandle != nullptr)
+    {
+      suspended ? SuspendThread(wHandle) : ResumeThread(wHandle);
+      CloseHandle(wHandle);
+    }
+  }
+  CloseHandle(wSnapshot);
+#else
+  ::kill(static_cast<pid_t>(entry.mProcessId), suspended ? SIGSTOP : SIGCONT);
+#endif
+}
+
+JobScheduler::Admission JobScheduler::admission(const Entry& entry) const
+{
+  if (mBulkPaused && entry.mJob.mBulk)
+  {
+    return Admission::Wait;
+  }
+  if (entry.mJob.mSpeculative && (!mRunning.empty() || hasRealWork()))
+  {
+    return Admission::Wait; // one at a time and only on an otherwise idle scheduler
+  }
+
+  auto wCount = [](const auto& counts, const QString& device) {
+    auto wIt = counts.find(device);
+    return wIt == counts.end() ? 0 : wIt->second;
+  };
+
+  const QString& wSource = entry.mSourceDevice.mId;
+  if (!wSource.isEmpty() && wCount(mReaders, wSource) >= mDevices.readerLimit(entry.mSourceDevice.mType))
+  {
+    return Admission::Wait;
+  }
+  const QString& wDestination = entry.mDestinationDevice.mId;
+  if (!wDestination.isEmpty() && wCount(mWriters, wDestination) >= mMaxWritersPerDevice)
+  {
+    return Admission::Wait;
+  }
+
+  // the running jobs have not written all of their outputs yet, their estimates are reserved
+  if (entry.mJob.mOutputBytes > 0)
+  {
+    const qint64 wAvailable = DeviceAdmission::availableBytes(entry.mJob.mDestinationPath);
+    if (wAvailable >= 0 && entry.mJob.mOutputBytes + sFreeSpaceMargin > wAvailable - wCount(mReservedBytes, wDestination))
+    {
+      // nothing to wait for if no running job is writing there
+      return wCount(mWriters, wDestination) == 0 ? Admission::Never : Admission::Wait;
+    }
+  }
+  return Admission::Admitted;
+}
+
+bool JobScheduler::hasRealWork() const
+{
+  auto wReal = [](const Job& job) { return !job.mSpeculative; };
+  return std::any_of(mPending.begin(), mPending.end(), [&wReal](const Entry& entry) { return wReal(entry.mJob); })
+    || std::any_of(mRunning.begin(), mRunning.end(), [&wReal](const auto& running) { return wReal(running.second.mJob); });
+}
+
+void JobScheduler::start(Entry&& entry)
+{
+  const Job::Id wId = entry.mId;
+  entry.mConcurrency = ++mReaders[entry.mSourceDevice.mId];
+  ++mWriters[entry.mDestinationDevice.mId];
+  mReservedBytes[entry.mDestinationDevice.mId] += entry.mJob.mOutputBytes;
+  entry.mTimer.start();
+
+  entry.mThreads = threadShare(entry);
+  const QStringList wArguments = entry.mThreads > 0 ? threadedArguments(entry.mJob.mArguments, entry.mThreads) : entry.mJob.mArguments;
+  mIo.start(wId, entry.mJob, wArguments, mBackground || entry.mJob.mSpeculative);
+  mRunning.emplace(wId, std::move(entry));
+  if (!mDrainTimer.isActive())
+  {
+    mDrainTimer.start();
+  }
+}
+
+void JobScheduler::drainEvents()
+{
+  // progress is reported once per drain and job, the latest one, but always before the job finishes
+  std::map<Job::Id, VTime> wProgress;
+  auto wReportProgress = [this, &wProgress](const Job::Id id) {
+    auto wIt = wProgress.find(id);
+    if (wIt != wProgress.end())
+    {
+      emit jobProgress(id, wIt->second);
+      wProgress.erase(wIt);
+    }
+  };
+
+  ProcessEvent wEvent;
+  while (mIo.poll(wEvent))
+  {
+    switch (wEvent.mType)
+    {
+      case ProcessEvent::Type::Started:
+      {
+        auto wIt = mRunning.find(wEvent.mId);
+        if (wIt != mRunning.end())
+        {
+          wIt->second.mProcessId = wEvent.mProcessId;
+          applyPriority(wIt->second); // the background mode may have changed since the start was requested
+          shedLoad();                 // and the limits
+        }
+        emit jobStarted(wEvent.mId);
+        break;
+      }
+      case ProcessEvent::Type::Progress:
+        wProgress[wEvent.mId] = wEvent.mTime;
+        break;
+      case ProcessEvent::Type::Finished:
+        wReportProgress(wEvent.mId);
+        onFinished(wEvent.mId, wEvent.mSucceeded);
+        break;
+    }
+  }
+  while (!wProgress.empty())
+  {
+    wReportProgress(wProgress.begin()->first);
+  }
+
+  if (mRunning.empty())
+  {
+    mDrainTimer.stop();
+  }
+}
+
+void JobScheduler::onFinished(const Job::Id id, const bool succeeded)
+{
+  auto wIt = mRunning.find(id);
+  if (wIt == mRunning.end())
+  {
+    return;
+  }
+
+  const Entry& wEntry = wIt->second;
+  --mReaders[wEntry.mSourceDevice.mId];
+  --mWriters[wEntry.mDestinationDevice.mId];
+  mReservedBytes[wEntry.mDestinationDevice.mId] -= wEntry.mJob.mOutputBytes;
+
+  if (wEntry.mPreempted)
+  {
+    // starts over from scratch when the scheduler is idle again, the owner only sees a second start
+    Entry wRequeued = std::move(wIt->second);
+    mRunning.erase(wIt);
+    wRequeued.mProcessId = 0;
+    wRequeued.mThreads = 0;
+    wRequeued.mPreempted = false;
+    wRequeued.mSuspended = false;
+    wRequeued.mInterrupted = false;
+    mPending.push_back(std::move(wRequeued));
+    schedule();
+    return;
+  }
+
+  // nobody asked for it yet, e.g. its window is gone
+  if (!succeeded && wEntry.mJob.mSpeculative)
+  {
+    QFile::remove(wEntry.mJob.mDestinationPath);
+  }
+
+  // stream copies are bound by the disk, not by the cpu, their speed tells what the device is capable of
+  bool wLimitsLearned = false;
+  if (succeeded && wEntry.mThreads == 0 && !wEntry.mJob.mSpeculative && !wEntry.mInterrupted && wEntry.mJob.mInputBytes > 0 && wEntry.mTimer.elapsed() > 0)
+  {
+    const double wBytesPerSecond = wEntry.mJob.mInputBytes * 1000.0 / wEntry.mTimer.elapsed();
+    wLimitsLearned = mDevices.recordThroughput(wEntry.mSourceDevice.mType, wEntry.mConcurrency, wBytesPerSecond * wEntry.mConcurrency);
+  }
+
+  mRunning.erase(wIt);
+
+  emit jobFinished(id, succeeded);
+  if (wLimitsLearned)
+  {
+    emit deviceLimitsLearned();
+  }
+  schedule();
+}
+
+void JobScheduler::applyPriority(const Entry& entry) const
+{
+#ifdef Q_OS_WIN
+  if (entry.mProcessId == 0)
+  {
+    return; // not started yet, it gets the class on creation
+  }
+
+  HANDLE wHandle = OpenProcess(PROCESS_SET_INFORMATION, FALSE, static_cast<DWORD>(entry.mProcessId));
+  if (wHandle != nullptr)
+  {
+    SetPriorityClass(wHandle, mBackground || entry.mJob.mSpeculative ? IDLE_PRIORITY_CLASS : BELOW_NORMAL_PRIORITY_CLASS);
+    CloseHandle(wHandle);
+  }
+#else
+  Q_UNUSED(entry);
+#endif
+}
+
+unsigned JobScheduler::threadShare(const Entry& entry) const
+{
+  if (!isThreaded(entry.mJob))
+  {
+    return 0;
+  }
+
+  const unsigned wBudget = mThreadBudget > 0 ? mThreadBudget : static_cast<unsigned>(std::max(1, QThread::idealThreadCount()));
+
+  // the threaded jobs able to run side by side split the budget evenly, a lone job gets all of it
+  unsigned wConcurrent = 1;
+  for (const auto& wRunning : mRunning)
+  {
+    wConcurrent += wRunning.second.mThreads > 0 ? 1 : 0;
+  }
+  for (const Entry& wPending : mPending)
+  {
+    wConcurrent += isThreaded(wPending.mJob) ? 1 : 0;
+  }
+  wConcurrent = std::min(wConcurrent, std::min(mMaxRunning, mRunningLimit));
+
+  // the running jobs can not give back their threads, a job started next to them gets what is left,
+  // the ones started after they finished get the bigger shares
+  const unsigned wUsed = usedThreads();
+  const unsigned wFree = wBudget > wUsed ? wBudget - wUsed : 0;
+  return std::max(1u, std::min(wBudget / std::max(1u, wConcurrent), wFree));
+}
+
+bool JobScheduler::isThreaded(const Job& job)
+{
+  return job.mArguments.contains(QLatin1String(Job::sThreadCount));
+}
+
+QStringList JobScheduler::threadedArguments(const QStringList& arguments, const unsigned threads)
+{
+  const QString wThreads = QString::number(threads);
+
+  // filter threads are global options, the decoders get the same count as the encoders
+  QStringList wArguments = { "-filter_threads", wThreads, "-filter_complex_threads", wThreads };
+  for (const QString& wArgument : arguments)
+  {
+    if (wArgument == "-i")
+    {
+      wArguments.append({ "-threads", wThreads });
+    }
+    wArguments.append(wArgument == QLatin1String(Job::sThreadCount) ? wThreads : wArgument);
+  }
+  return wArguments;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "JobQueue.h"
+#include "DeviceAdmission.h"
+#include "ProcessIo.h"
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <deque>
+#include <limits>
+#include <map>
+
+// queues the encoder processes and starts them when there is a free slot, globally and on the source and destination devices,
+// and there is space for the estimated output
+// the processes run below normal priority, in background mode at idle priority, so they never compete with the playback
+// their output is handled by ProcessIo, this thread only takes the parsed records, once per frame
+// speculative jobs run one at a time at idle priority when nothing else is to do, a real job preempts them and they are queued again,
+// the partial output of one that did not succeed is removed, also of the ones still running when the scheduler goes
+// the throttle holds the running processes too: the ones above the running limit and the bulk ones are suspended,
+// the newest first, and they resume before anything new starts
+class JobScheduler : public JobQueue
+{
+  Q_OBJECT
+
+public:
+  JobScheduler(QObject* parent = nullptr);
+  ~JobScheduler();
+
+  Job::Id submit(const Job& job) override;
+  void cancel(const Job::Id id) override;
+  void promote(const Job::Id id) override;
+
+  void setMaxRunning(const unsigned maxRunning) override;
+  void setMaxReadersPerDevice(const unsigned maxReaders) override; // the starting point, the limit per device type is learned, see DeviceAdmission
+  void setMaxWritersPerDevice(const unsigned maxWriters) override;
+  unsigned maxRunning() const override;
+  void setThreadBudget(const unsigned threads) override; // 0 is one per logical core
+
+  void setRunningLimit(const unsigned limit) override; // further limits maxRunning, the running jobs above it are suspended
+  void setBulkPaused(const bool paused) override;      // bulk jobs are not started, the running ones are suspended
+  void setBackground(const bool background) override;  // idle cpu priority for the running and the new processes
+
+  std::map<QString, int> learnedDeviceLimits() const override;
+  void setLearnedDeviceLimits(const std::map<QString, int>& limits) override;
+
+  size_t pendingCount() const;
+  size_t runningCount() const;
+  unsigned usedThreads() const;
+
+private:
+  struct Entry
+  {
+    Job::Id mId = 0;
+    Job mJob;
+    DeviceAdmission::Device mSourceDevice;
+    DeviceAdmission::Device mDestinationDevice;
+    qint64 mProcessId = 0; // 0 until started
+    unsigned mThreads = 0;
+    unsigned mConcurrency = 0; // readers of the source device, this one included, at start
+    QElapsedTimer mTimer;
+    bool mPreempted = false; // killed for a real job, queued again when the process is gone
+    bool mSuspended = false;
+    bool mInterrupted = false; // was suspended, its time tells nothing about the device
+  };
+
+  enum class Admission { Admitted, Wait, Never };
+
+  void schedule();
+  void shedLoad();
+  size_t activeCount() const; // running and not suspended
+  void setSuspended(Entry& entry, const bool suspended);
+  Admission admission(const Entry& entry) const;
+  bool hasRealWork() const;
+  void start(Entry&& entry);
+  void drainEvents();
+  void onFinished(const Job::Id id, const bool succeeded);
+  void applyPriority(const Entry& entry) const;
+  unsigned threadShare(const Entry& entry) const;
+  static bool isThreaded(const Job& job);
+  static QStringList threadedArguments(const QStringList& arguments, const unsigned threads);
+
+  std::deque<Entry> mPending;
+  std::map<Job::Id, Entry> mRunning;
+  std::map<QString, unsigned> mReaders;
+  std::map<QString, unsigned> mWriters;
+  std::map<QString, qint64> mReservedBytes; // estimated outputs of the running jobs, by device
+  DeviceAdmission mDevices;
+  ProcessIo mIo;
+  QTimer mDrainTimer;
+
+  Job::Id mLastId = 0;
+  unsigned mMaxRunning = 4;
+  unsigned mMaxWritersPerDevice = 2;
+  unsigned mThreadBudget = 0;
+  unsigned mRunningLimit = std::numeric_limits<unsigned>::max();
+  bool mBulkPaused = false;
+  bool mBackground = false;
+
+  static constexpr qint64 sFreeSpaceMargin = 256ll * 1024 * 1024;
+  static constexpr int sDrainIntervalMs = 16; // a frame at 60 Hz
+};
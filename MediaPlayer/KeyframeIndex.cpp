@@ -0,0 +1,200 @@
+#include "KeyframeIndex.h"
+
+#include <QProcess>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#endif
+
+KeyframeIndex::KeyframeIndex(const QString& ffprobePath, QObject* parent)
+  : QObject(parent)
+  , mFFProbePath(ffprobePath)
+{}
+
+KeyframeIndex::~KeyframeIndex()
+{
+  if (mProcess)
+  {
+    mProcess->disconnect(this);
+    mProcess->kill();
+    mProcess->waitForFinished(1000);
+  }
+}
+
+void KeyframeIndex::load(const QUrl& video)
+{
+  if (video == mVideo)
+  {
+    return;
+  }
+
+  if (mProcess)
+  {
+    QProcess* wProcess = mProcess.release();
+    wProcess->disconnect(this);
+    wProcess->kill();
+    connect(wProcess, &QProcess::finished, wProcess, &QObject::deleteLater);
+  }
+  mVideo = video;
+  mReady = false;
+  mKeyframes.clear();
+  mStartTime = 0.0;
+  mPartialLine.clear();
+  if (mVideo.isEmpty())
+  {
+    return;
+  }
+
+  // only the packet flags are read, nothing is decoded, the demuxer still walks the whole file
+  mProcess = std::make_unique<QProcess>();
+#ifdef Q_OS_WIN
+  mProcess->setCreateProcessArgumentsModifier([](QProcess::CreateProcessArguments* arguments) {
+    arguments->flags |= BELOW_NORMAL_PRIORITY_CLASS;
+    });
+#endif
+  connect(mProcess.get(), &QProcess::readyReadStandardOutput, this, &KeyframeIndex::onOutput);
+  connect(mProcess.get(), &QProcess::finished, this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+    onFinished(exitCode == 0 && exitStatus == QProcess::NormalExit);
+    });
+  connect(mProcess.get(), &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+    if (error == QProcess::FailedToStart)
+    {
+      onFinished(false);
+    }
+    });
+  mProcess->start(mFFProbePath, { "-v", "error",
+                                  "-select_streams", "v:0",
+                                  "-show_entries", "packet=pts_time,flags:format=start_time",
+                                  "-of", "csv=p=0",
+                                  mVideo.toLocalFile() });
+}
+
+const QUrl& KeyframeIndex::video() const
+{
+  return mVideo;
+}
+
+bool KeyframeIndex::isReady() const
+{
+  return mReady;
+}
+
+bool KeyframeIndex::isReady(const QUrl& video) const
+{
+  return mReady && video == mVideo;
+}
+
+VTime KeyframeIndex::nearest(const VTime& time) const
+{
+  const std::optional<VTime> wBefore = atOrBefore(time);
+  const std::optional<VTime> wAfter = after(time);
+  if (!wBefore)
+  {
+    return wAfter.value_or(time);
+  }
+  if (!wAfter)
+  {
+    return *wBefore;
+  }
+  return (time - *wBefore) <= (*wAfter - time) ? *wBefore : *wAfter;
+}
+
+std::optional<VTime> KeyframeIndex::atOrBefore(const VTime& time) const
+{
+  if (!mReady)
+  {
+    return std::nullopt;
+  }
+  auto wIt = std::upper_bound(mKeyframes.begin(), mKeyframes.end(), time);
+  if (wIt == mKeyframes.begin())
+  {
+    return std::nullopt;
+  }
+  return *std::prev(wIt);
+}
+
+std::optional<VTime> KeyframeIndex::after(const VTime& time) const
+{
+  if (!mReady)
+  {
+    return std::nullopt;
+  }
+  auto wIt = std::upper_bound(mKeyframes.begin(), mKeyframes.end(), time);
+  if (wIt == mKeyframes.end())
+  {
+    return std::nullopt;
+  }
+  return *wIt;
+}
+
+const std::vector<VTime>& KeyframeIndex::keyframes() const
+{
+  return mKeyframes;
+}
+
+void KeyframeIndex::onOutput()
+{
+  // a long file lists millions of packets, they are parsed as they come, not buffered
+  QByteArray wOutput = mPartialLine + mProcess->readAllStandardOutput();
+  const qsizetype wEnd = wOutput.lastIndexOf('\n') + 1;
+  mPartialLine = wOutput.mid(wEnd);
+  for (const QByteArray& wLine : wOutput.left(wEnd).split('\n'))
+  {
+    parseLine(wLine.trimmed());
+  }
+}
+
+void KeyframeIndex::parseLine(const QByteArray& line)
+{
+  // "pts_time,flags" of a packet, e.g. "12.345000,K__", or the single "start_time" of the format
+  const QList<QByteArray> wFields = line.split(',');
+  bool wOk = false;
+  const double wTime = wFields.front().toDouble(&wOk);
+  if (!wOk)
+  {
+    return; // empty or N/A
+  }
+  if (wFields.size() == 1)
+  {
+    mStartTime = wTime;
+  }
+  else if (wFields[1].startsWith('K'))
+  {
+    mKeyframes.emplace_back(static_cast<qint64>(std::llround(wTime * 1000.0)));
+  }
+}
+
+void KeyframeIndex::onFinished(const bool succeeded)
+{
+  if (!mProcess)
+  {
+    return;
+  }
+  onOutput(); // what is left in the pipe
+
+  QProcess* wProcess = mProcess.release();
+  wProcess->disconnect(this);
+  wProcess->deleteLater(); // we are in its signal
+  if (!succeeded)
+  {
+    mKeyframes.clear();
+    return; // stays not ready, the callers fall back to plain seeks
+  }
+
+  parseLine(mPartialLine.trimmed());
+  mPartialLine.clear();
+
+  // the packets come in decode order, the player counts from the start of the file
+  const VTime wStart(static_cast<qint64>(std::llround(mStartTime * 1000.0)));
+  for (VTime& wKeyframe : mKeyframes)
+  {
+    wKeyframe = wKeyframe > wStart ? wKeyframe - wStart : VTime(0);
+  }
+  std::sort(mKeyframes.begin(), mKeyframes.end());
+  mKeyframes.erase(std::unique(mKeyframes.begin(), mKeyframes.end()), mKeyframes.end());
+  mReady = true;
+  emit ready();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "VTime.h"
+
+#include <QObject>
+#include <QString>
+#include <QUrl>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+class QProcess;
+
+// the keyframe times of the video stream of a file, listed by ffprobe in the background
+// the times are relative to the start of the file, as the positions of the player
+class KeyframeIndex : public QObject
+{
+  Q_OBJECT
+
+public:
+  KeyframeIndex(const QString& ffprobePath, QObject* parent = nullptr);
+  ~KeyframeIndex();
+
+  void load(const QUrl& video); // no-op for the file loaded or being loaded, an empty url clears the index
+  const QUrl& video() const;
+  bool isReady() const;
+  bool isReady(const QUrl& video) const;
+
+  VTime nearest(const VTime& time) const;                 // the time itself while not ready
+  std::optional<VTime> atOrBefore(const VTime& time) const; // empty while not ready or before the first one
+  std::optional<VTime> after(const VTime& time) const;      // empty while not ready or after the last one
+  const std::vector<VTime>& keyframes() const;
+
+signals:
+  void ready();
+
+private:
+  void onOutput();
+  void onFinished(const bool succeeded);
+  void parseLine(const QByteArray& line);
+
+  const QString mFFProbePath;
+  std::unique_ptr<QProcess> mProcess;
+  QUrl mVideo;
+  bool mReady = false;
+  std::vector<VTime> mKeyframes;
+  double mStartTime = 0.0; // sec, the first timestamp of the file
+  QByteArray mPartialLine;
+};
@@ -132,8 +132,9 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
   }
   case Qt::Key_P:
   {
-    mMediaPlayer->setSettings({ !mMediaPlayer->getSettings().mAutoPlay
-                                , mMediaPlayer->getSettings().mAudioMode });
+    Settings wSettings = mMediaPlayer->getSettings();
+    wSettings.mAutoPlay = !wSettings.mAutoPlay;
+    mMediaPlayer->setSettings(wSettings);
     break;
   }
   case Qt::Key_A:
@@ -158,6 +159,12 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
   }
   case Qt::Key_S:
   {
+    if (event->modifiers() & Qt::ShiftModifier)
+    {
+      mMediaPlayer->cut(MediaPlayer::CutMethod::Frames); // every Nth frame of the sequences
+      break;
+    }
+    mMediaPlayer->captureFrame();
     break;
   }
   case Qt::Key_D:
@@ -289,12 +296,17 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
   case Qt::Key_B:
   {
     MediaPlayer::CutMethod wCutMethod = MediaPlayer::CutMethod::Fast;
-    if (event->modifiers() & Qt::ShiftModifier)
+    if ((event->modifiers() & Qt::ShiftModifier) && (event->modifiers() & Qt::AltModifier))
+    {
+      wCutMethod = MediaPlayer::CutMethod::Sized;
+    }
+    else if (event->modifiers() & Qt::ShiftModifier)
     {
       wCutMethod = MediaPlayer::CutMethod::Precise;
     }
     else if (event->modifiers() & Qt::AltModifier)
     {
+      wCutMethod = MediaPlayer::CutMethod::Ladder;
     }
     else if (event->modifiers() & Qt::ControlModifier)
     {
@@ -303,11 +315,68 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
     mMediaPlayer->cut(wCutMethod);
     break;
   }
+  case Qt::Key_G:
+  {
+    mMediaPlayer->cut(MediaPlayer::CutMethod::Animation);
+    break;
+  }
+  case Qt::Key_T:
+  {
+    mMediaPlayer->cut(MediaPlayer::CutMethod::TimeLapse);
+    break;
+  }
+  case Qt::Key_M:
+  {
+    mMediaPlayer->batchCut(event->modifiers() & Qt::ShiftModifier); // shift re-encodes with the encode filters
+    break;
+  }
+  case Qt::Key_E:
+  {
+    if (event->modifiers() & Qt::ShiftModifier)
+    {
+      mMediaPlayer->exportChapters();
+    }
+    else
+    {
+      mMediaPlayer->exportSequences();
+    }
+    break;
+  }
   case Qt::Key_Space:
   {
+    if (event->modifiers() & Qt::ShiftModifier)
+    {
+      mMediaPlayer->reversePlay();
+      break;
+    }
     mMediaPlayer->startStop();
     break;
   }
+  case Qt::Key_U:
+  {
+    mMediaPlayer->toggleGrid();
+    break;
+  }
+  case Qt::Key_J:
+  {
+    mMediaPlayer->shuttle(-1);
+    break;
+  }
+  case Qt::Key_K:
+  {
+    mMediaPlayer->shuttle(0);
+    break;
+  }
+  case Qt::Key_L:
+  {
+    mMediaPlayer->shuttle(1);
+    break;
+  }
+  case Qt::Key_Q:
+  {
+    mMediaPlayer->loopPlay(event->modifiers().testFlag(Qt::ShiftModifier));
+    break;
+  }
   case Qt::Key_Tab:
   {
     mMediaPlayer->filter();
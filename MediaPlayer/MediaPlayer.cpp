@@ -2,33 +2,188 @@
 #include "VideoPlayer.h"
 #include "View.h"
 #include "Utils.h"
+#include "SizePredictor.h"
+#include "DurationProber.h"
+#include "QosController.h"
+#include "JobScheduler.h"
+#include "JobClient.h"
+#include "Prefetcher.h"
+#include "KeyframeIndex.h"
+#include "ReversePlayer.h"
+#include "SeekTargets.h"
+#include "GridPlayer.h"
 
 #include <QFileInfo.h>
 #include <QMediaMetadata.h>
 #include <QUrl>
 #include <QThread>
+#include <QCoreApplication>
 #include <QProcess>
 #include <QMessageBox>
 #include <QFileInfo>
 #include <QDir>
 #include <QRegularExpression>
+#include <QVideoFrame>
+#include <QImage>
 
 #include <random>
 #include <fstream>
 #include <filesystem>
 #include <algorithm>
+#include <array>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#endif
+
+namespace
+{
+
+// each press of the shuttle key of the playing direction doubles the speed
+constexpr std::array<double, 6> sShuttleRates = { 1.0, 2.0, 4.0, 8.0, 16.0, 32.0 };
+
+std::unique_ptr<JobQueue> createJobQueue()
+{
+  // the daemon keeps the jobs running after the window is closed
+  auto wClient = std::make_unique<JobClient>();
+  if (wClient->connectToDaemon(QCoreApplication::applicationFilePath()))
+  {
+    return wClient;
+  }
+  return std::make_unique<JobScheduler>();
+}
+
+bool isProcessRunning(const qint64 processId)
+{
+#ifdef Q_OS_WIN
+  HANDLE wProcess = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(processId));
+  if (wProcess == nullptr)
+  {
+    return false;
+  }
+  const bool wRunning = WaitForSingleObject(wProcess, 0) == WAIT_TIMEOUT;
+  CloseHandle(wProcess);
+  return wRunning;
+#else
+  Q_UNUSED(processId);
+  return true; // unknown, the file is kept
+#endif
+}
+
+bool replaceFile(const QString& source, const QString& destination)
+{
+  QFile::remove(destination);
+  return QFile::rename(source, destination);
+}
+
+// '=', ';', '#', '\\' and line breaks are special in the ffmetadata format
+QString escapeMetadata(QString value)
+{
+  static const QRegularExpression re(R"(([=;#\\\n]))");
+  return value.replace(re, R"(\\1)");
+}
+
+}
 
 MediaPlayer::MediaPlayer(QObject* parent)
   : QObject(parent)
   , mView(std::make_shared<View>())
   , mPlayer(std::make_shared<VideoPlayer>(mView->getVideoWidget()))
+  , mScheduler(createJobQueue())
+  , mQos(std::make_unique<QosController>(mScheduler.get()))
+  , mPrefetcher(std::make_unique<Prefetcher>())
+  , mKeyframes(std::make_unique<KeyframeIndex>(utils::ffprobePath()))
+  , mReversePlayer(std::make_unique<ReversePlayer>(mFFMpegPath, mPlayer.get(), mKeyframes.get()))
+  , mSeekTargets(std::make_unique<SeekTargets>(mFFMpegPath, mKeyframes.get()))
+  , mGridPlayer(std::make_unique<GridPlayer>(mFFMpegPath))
 {
+  connect(mView.get(), &View::tileHovered, this, [this](std::size_t index) { mGridPlayer->setFocus(index); });
+  connect(mGridPlayer.get(), &GridPlayer::focused, this, [this](std::size_t index) {
+    // the focused tile gets the most of the decode budget and the standby opens it, a click swaps to it
+    mPlayer->prepare(mGridPlayer->video(index));
+    });
+  connect(mView.get(), &View::tileClicked, this, &MediaPlayer::promoteTile);
+  connect(mKeyframes.get(), &KeyframeIndex::ready, this, [this]() { prepareSeekTargets(); }); // on keyframes from now on
+  connect(mReversePlayer.get(), &ReversePlayer::finished, this, [this]() {
+    if (mLoop && mPingPong)
+    {
+      // back at the start of the loop, forward again from the frame on screen
+      preloadReverseLoop();
+      play();
+      return;
+    }
+    mQos->setPlaying(false);
+    mView->onPause();
+    mView->setPlaybackHealth(std::nullopt);
+    SetThreadExecutionState(ES_CONTINUOUS);
+    });
+  connect(mPlayer.get(), &VideoPlayer::beginReached, this, [this]() {
+    mPlaying = false;
+    mView->onPause();
+    SetThreadExecutionState(ES_CONTINUOUS);
+    });
+  connect(mPlayer.get(), &VideoPlayer::playbackStatistics, this, [this](const PlaybackStatistics& statistics) { mView->setPlaybackHealth(statistics); });
+  connect(mPlayer.get(), &VideoPlayer::playingChanged, this, [this](bool playing) {
+    if (!playing && !mReversePlayer->isRunning())
+    {
+      mView->setPlaybackHealth(std::nullopt);
+    }
+    });
+  mPlayer->setKeyframeIndex(mKeyframes.get());
+  connect(mPlayer.get(), &VideoPlayer::seekStatistics, this, [this](const SeekStatistics& statistics) {
+    if (statistics.mInteractive)
+    {
+      mView->setSeekStatistics(statistics); // the loads and the loops seek too, they would only hide what the user did
+    }
+    });
+  connect(mScheduler.get(), &JobQueue::jobRejected, this, [this](Job::Id, const QString& reason) { logStatusMessage("Job rejected: " + reason); });
+  connect(mScheduler.get(), &JobQueue::deviceLimitsLearned, this, [this]() { mSettings.mDeviceReaderLimits = mScheduler->learnedDeviceLimits(); });
+  connect(mPlayer.get(), &VideoPlayer::playingChanged, mQos.get(), &QosController::setPlaying);
+  connect(mPlayer.get(), &VideoPlayer::playbackStatistics, mQos.get(), &QosController::onPlaybackStatistics);
+
+  connect(mScheduler.get(), &JobQueue::jobStarted, this, [this](Job::Id id) {
+    auto wIt = mJobHandlers.find(id);
+    if (wIt != mJobHandlers.end() && wIt->second.mStarted)
+    {
+      wIt->second.mStarted();
+    }
+    });
+  connect(mScheduler.get(), &JobQueue::jobProgress, this, [this](Job::Id id, VTime time) {
+    auto wIt = mJobHandlers.find(id);
+    if (wIt != mJobHandlers.end() && wIt->second.mProgress)
+    {
+      wIt->second.mProgress(time);
+    }
+    });
+  connect(mScheduler.get(), &JobQueue::jobFinished, this, [this](Job::Id id, bool succeeded) {
+    auto wIt = mJobHandlers.find(id);
+    if (wIt == mJobHandlers.end())
+    {
+      return;
+    }
+    // the handler may submit the next step of a chain, which adds to the map
+    JobHandlers wHandlers = std::move(wIt->second);
+    mJobHandlers.erase(wIt);
+    if (wHandlers.mFinished)
+    {
+      wHandlers.mFinished(succeeded);
+    }
+    });
+
   connect(mPlayer.get(), &VideoPlayer::positionChanged, this, [this](VTime position) { mView->setPosition(position); });
   connect(mPlayer.get(), &VideoPlayer::durationChanged, this, [this](VTime duration) { mView->setDuration(duration); });
   connect(mPlayer.get(), &VideoPlayer::videoLoaded,     this, &MediaPlayer::onVideoLoaded);
   connect(mPlayer.get(), &VideoPlayer::videoEnded,      this, &MediaPlayer::onVideoEnded);
+  connect(mPlayer.get(), &VideoPlayer::loopEnded, this, [this]() {
+    if (!mLoop || !mPingPong)
+    {
+      return;
+    }
+    mReversePlayer->start(Playlist::fileUrl(mPlaylist.current()), mLoop->second, mLoop->first, frameRate(), mPlayer->playbackRate());
+    mQos->setPlaying(mReversePlayer->isRunning());
+    });
 
-  connect(mView.get(), &View::sliderChanged,          this, [this](int position) {setPosition(static_cast<VTime>(position), true); });
+  connect(mView.get(), &View::sliderChanged,          this, [this](int position) { loadKeyframes(); scrub(static_cast<VTime>(position)); });
   connect(mView.get(), &View::previousButtonClicked,  this, [this]() { previous(); });
   connect(mView.get(), &View::startStopButtonClicked, this, [this]() { startStop(); });
   connect(mView.get(), &View::nextButtonClicked,      this, [this]() { next(); });
@@ -41,6 +196,7 @@ MediaPlayer::MediaPlayer(QObject* parent)
     {
       mPlaylist.setOrder(state, true);
       mSettings.mRandomize = state;
+      prepareNext();
     });
   connect(mView.get(), &View::onMouseClick, this, [this]() { stop();  });
   connect(mView.get(), &View::videoItemDoubleClicked, this, [this](const QUrl url) 
@@ -51,19 +207,35 @@ MediaPlayer::MediaPlayer(QObject* parent)
     {
       return;
     }
+    if (mGridSize > 0)
+    {
+      // the grid pages to the entry
+      mPlaylist.setCurrentIndex(mPlaylist.indexOf(*it));
+      showGrid();
+      return;
+    }
     stop();
+    stopLoop();
 
     mPlaylist.setCurrentIndex(mPlaylist.indexOf(*it));
+    mPreviewing = false;
+    mLoadPosition.reset();
     mPlayer->setVideo(mPlaylist.current());
+    dropSpeculations();
     mSequenceMap.clear();
     mView->setSequences(mSequenceMap);
 
     play();
   });
-  connect(mView.get(), &View::speedChanged, this, [this](double speed) { mPlayer->setPlaybackRate(speed); });
+  connect(mView.get(), &View::speedChanged, this, [this](double speed) { mPlayer->setPlaybackRate(speed); mReversePlayer->setRate(speed); showReverseHealth(); });
   connect(mView.get(), &View::volumeChanged, this, [this](double volume) { mPlayer->setVolume(static_cast<float>(volume)); mSettings.mVolume = static_cast<float>(volume); });
   connect(mView.get(), &View::FilterCommited, this, [this]() { 
     mView->focusPlayButton(); 
+    if (mGridSize > 0)
+    {
+      showGrid(); // from the current entry of the filtered list
+      return;
+    }
 
     const bool wasPlaying = isPlaying();
     if (wasPlaying)
@@ -73,6 +245,7 @@ MediaPlayer::MediaPlayer(QObject* parent)
 
     const std::size_t viewIdx = mPlaylist.viewIndexOfCurrent();
     mView->setCurrentVideo(static_cast<int>(viewIdx));
+    mPreviewing = false; // the filtered list may not show the previewed source anymore, it is left
     mPlayer->setVideo(mPlaylist.current());
     
     if (wasPlaying)
@@ -91,11 +264,23 @@ MediaPlayer::MediaPlayer(QObject* parent)
     qDebug() << "double clicked sequence" << wSequence->first.ms() << wSequence->second.ms();
     QString wFileName = QFileInfo(mPlaylist.current().toString()).fileName();
 
+    if (mPreviewing)
+    {
+      stopPreview();
+      return;
+    }
+
     auto wSequenceEntry = mSequenceMap.find(*wSequence);
     if (wSequenceEntry == mSequenceMap.end())
     {
       return;
     }
+
+    if (wSequenceEntry->second.mState == OperationState::Processing && wSequenceEntry->second.mFragmented)
+    {
+      startPreview(wSequenceEntry->first);
+      return;
+    }
   
     if (wSequenceEntry->second.mState != OperationState::Succeeded || !QFile(wSequenceEntry->second.mFilePath).exists())
     {
@@ -108,10 +293,16 @@ MediaPlayer::MediaPlayer(QObject* parent)
 
   mPlayer->setVolume(0.0f);
   mPlayer->setPlaybackRate(1.0);
+
+  mImagePool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2)); // leave the rest to the decoder of the player
+
+  removeSpeculationLeftovers();
 }
 
 MediaPlayer::~MediaPlayer()
-{}
+{
+  dropSpeculations(); // the daemon would run them for nobody, the scheduler removes their partial outputs
+}
 
 void MediaPlayer::onFilterTextChanged(const QString& text)
 {
@@ -122,7 +313,9 @@ void MediaPlayer::onFilterTextChanged(const QString& text)
 
   mPlaylist.setFilter(text);
   mPlaylist.setOrder(mSettings.mRandomize);
+  prepareNext();
 
+  dropSpeculations();
   mSequenceMap.clear();
   mView->setSequences(mSequenceMap);  // TODO: store the sequences associated to the video, not the player, so that we can have different sequences for each video in the playlist
 
@@ -137,11 +330,14 @@ void MediaPlayer::setPlaylist(const Playlist& playlist)
     return;
   }
 
+  stopLoop();
+  closeGrid();
   mPlaylist = playlist;
   mPlaylist.setOrder(mSettings.mRandomize);
 
   mPlayer->setVideo(mPlaylist.current());
 
+  dropSpeculations();
   mSequenceMap.clear();
   mView->setSequences(mSequenceMap);  // TODO: store the sequences associated to the video, not the player, so that we can have different sequences for each video in the playlist
 
@@ -173,6 +369,17 @@ void MediaPlayer::setSettings(const Settings& settings)
   mView->setVolume(mSettings.mVolume);
   mView->setRandomize(mSettings.mRandomize);
   mPlaylist.setOrder(mSettings.mRandomize);
+  prepareNext();
+
+  mScheduler->setMaxRunning(static_cast<unsigned>(std::max(1, mSettings.mMaxJobs)));
+  mScheduler->setMaxReadersPerDevice(static_cast<unsigned>(std::max(1, mSettings.mReadersPerDevice)));
+  mScheduler->setMaxWritersPerDevice(static_cast<unsigned>(std::max(1, mSettings.mWritersPerDevice)));
+  mScheduler->setThreadBudget(static_cast<unsigned>(std::max(0, mSettings.mThreadBudget)));
+  mScheduler->setLearnedDeviceLimits(mSettings.mDeviceReaderLimits);
+  mPlayer->setFrameRingBudget(static_cast<qint64>(std::max(0, mSettings.mFrameRingMB)) * 1024 * 1024);
+  mReversePlayer->setMaxHeight(mSettings.mReverseMaxHeight);
+  mPlayer->setKeyframeRate(mSettings.mKeyframeRate);
+  prepareSeekTargets();
 }
 
 const Settings& MediaPlayer::getSettings() const
@@ -187,6 +394,7 @@ bool MediaPlayer::isPlaying() const
 
 void MediaPlayer::play()
 {
+  stopReverse();
   mPlayer->play();
   mView->onPlay();
   mPlaying = true;
@@ -196,6 +404,7 @@ void MediaPlayer::play()
 
 void MediaPlayer::pause()
 {
+  stopReverse();
   mPlayer->pause();
   mPlaying = false;
   
@@ -206,6 +415,7 @@ void MediaPlayer::pause()
 
 void MediaPlayer::stop()
 {
+  stopReverse();
   mPlayer->stop();
   mView->onStop();
   mPlaying = false;
@@ -215,19 +425,33 @@ void MediaPlayer::stop()
 
 void MediaPlayer::next()
 {
+  if (mGridSize > 0)
+  {
+    for (std::size_t i = 0; i < mGridSize; ++i)
+    {
+      mPlaylist.next();
+    }
+    showGrid();
+    return;
+  }
+
   const bool isPlaying = mPlaying;
+  stopLoop();
 
   if (mPlaylist.getVideos().size() == 1)
   {
-    setPosition(VTime(0), !isPlaying);
+    setPosition(entryStart(), !isPlaying);
   }
   else
   {
     mPlaylist.next();
 
     stop();
+    mPreviewing = false;
+    mLoadPosition.reset();
     mPlayer->setVideo(mPlaylist.current());
     mView->setCurrentVideo(static_cast<int>(mPlaylist.viewIndexOfCurrent()));
+    dropSpeculations();
     mSequenceMap.clear();
     mSelectedSequence = nullptr;
     mView->setSequences(mSequenceMap);  // TODO: store the sequences associated to the video, ...
@@ -241,21 +465,35 @@ void MediaPlayer::next()
 
 void MediaPlayer::previous()
 {
+  if (mGridSize > 0)
+  {
+    for (std::size_t i = 0; i < mGridSize; ++i)
+    {
+      mPlaylist.previous();
+    }
+    showGrid();
+    return;
+  }
+
   const bool isPlaying = mPlayer->isPlaying();
+  stopLoop();
 
   if (mPlaylist.getVideos().size() == 1)
   {
-    setPosition(VTime(0), !isPlaying);
+    setPosition(entryStart(), !isPlaying);
   }
   else
   {
     mPlaylist.previous();
 
     stop();
+    mPreviewing = false;
+    mLoadPosition.reset();
     mPlayer->setVideo(mPlaylist.current());
     const std::size_t viewIdx = mPlaylist.viewIndexOfCurrent();
     if (viewIdx != static_cast<std::size_t>(-1))
       mView->setCurrentVideo(static_cast<int>(viewIdx));
+    dropSpeculations();
     mSequenceMap.clear();
     mSelectedSequence = nullptr;
     mView->setSequences(mSequenceMap);  // TODO: store the sequences associated to the video, ...
@@ -309,9 +547,26 @@ bool MediaPlayer::isFullscreen() const
 
 void MediaPlayer::setPosition(const VTime& position, const bool updateNeeded)
 {
+  if (mGridSize > 0)
+  {
+    return; // the player is hidden behind the tiles
+  }
+  stopReverse();
+  mQos->notifyScrubbing();
   mPlayer->setPosition(position, updateNeeded);
 }
 
+void MediaPlayer::scrub(const VTime& position)
+{
+  if (mGridSize > 0)
+  {
+    return;
+  }
+  stopReverse();
+  mQos->notifyScrubbing();
+  mPlayer->scrub(position);
+}
+
 VTime MediaPlayer::getPosition() const
 {
   return mPlayer->getPosition();
@@ -324,44 +579,44 @@ QSize MediaPlayer::getVideoDimensions() const
 
 void MediaPlayer::seek(MediaPlayer::SeekDirection direction, MediaPlayer::SeekStep step)
 {
+  if (mGridSize > 0)
+  {
+    return;
+  }
+  stopReverse();
+  mQos->notifyScrubbing();
+  if (step == SeekStep::Small)
+  {
+    // a frame, not a fixed time, the frames shown lately come from memory
+    if (mPlaying)
+    {
+      pause();
+    }
+    mPlayer->stepFrame(direction == SeekDirection::Forward);
+    return;
+  }
+
+  loadKeyframes();
+  if (step == SeekStep::Random)
+  {
+    // chosen and decoded ahead, the frame is on screen before the player gets there, the next ones are prepared from there
+    const SeekTargets::Target wTarget = mSeekTargets->take(direction == SeekDirection::Forward, Playlist::fileUrl(mPlaylist.current()), mPlayer->getPosition(), mPlayer->getDuration());
+    mPlayer->jump(wTarget.mPosition, wTarget.mFrame);
+    prepareSeekTargets();
+    return;
+  }
+
   VTime wStepSize;
   switch (step)
   {
-    case SeekStep::Small:
-      wStepSize = VTime("00:00:00.025");
-      break;
     case SeekStep::Big:
       wStepSize = VTime("00:00:05.000");
       break;
     case SeekStep::Normal:
       wStepSize = VTime("00:00:00.500");
       break;
-    case SeekStep::Random:
-    {
-      const VTime wDuration = mPlayer->getDuration();
-      const VTime wPosition = mPlayer->getPosition();
-      const VTime wRemaining = mPlayer->getDuration() - mPlayer->getPosition();
-
-      VTime wSeekWindow = VTime(static_cast<qint64>(wDuration.ms() / 5.0f));
-      if (direction == SeekDirection::Forward)
-      {
-        if (wPosition + wSeekWindow >= wDuration)
-        {
-          wSeekWindow = wRemaining;
-        }
-      }
-      else if(direction == SeekDirection::Backward)
-      {
-        if (wPosition - wSeekWindow < VTime(0))
-        {
-          wSeekWindow = wPosition;
-        }
-      }
-
-      qint64 wMin = 10;
-      qint64 wMax = std::max(wMin, wSeekWindow.ms());
-      wStepSize = VTime(utils::Random(wMin, wMax));  // assuming 10 ms is left from the video, at least..
-    }
+    default:
+      break;
   }
 
   if (direction == SeekDirection::Forward)
@@ -380,7 +635,7 @@ void MediaPlayer::seek(MediaPlayer::SeekDirection direction, MediaPlayer::SeekSt
 
 void MediaPlayer::snapToSelection(MediaPlayer::SnapPosition position)
 {
-  if (mSelectedSequence == nullptr)
+  if (mSelectedSequence == nullptr || mGridSize > 0)
   {
     return;
   }
@@ -398,7 +653,11 @@ void MediaPlayer::snapToSelection(MediaPlayer::SnapPosition position)
 
 void MediaPlayer::startStop()
 {
-  if (isPlaying())
+  if (mGridSize > 0)
+  {
+    return; // the tiles play on their own
+  }
+  if (isPlaying() || mReversePlayer->isRunning())
   {
     pause();
   }
@@ -408,8 +667,277 @@ void MediaPlayer::startStop()
   }
 }
 
+void MediaPlayer::reversePlay()
+{
+  if (mReversePlayer->isRunning())
+  {
+    pause();
+    return;
+  }
+  if (mPreviewing || mGridSize > 0)
+  {
+    return;
+  }
+
+  // the keyframes let the gops start on a keyframe, without them the chunks are decoded from wherever ffmpeg finds one
+  pause();
+  loadKeyframes();
+  mReversePlayer->start(Playlist::fileUrl(mPlaylist.current()), mPlayer->getPosition(), entryStart(), frameRate(), mPlayer->playbackRate());
+  if (mReversePlayer->isRunning())
+  {
+    mQos->setPlaying(true); // the decoder needs the cpu as much as the playback
+    mView->onPlay();
+    showReverseHealth();
+    SetThreadExecutionState(ES_CONTINUOUS | ES_DISPLAY_REQUIRED | ES_SYSTEM_REQUIRED);
+  }
+}
+
+void MediaPlayer::shuttle(const int direction)
+{
+  if (mGridSize > 0)
+  {
+    return; // the audio of the hidden player would play behind the tiles
+  }
+  if (direction == 0)
+  {
+    mShuttleStep = 0;
+    pause();
+    return;
+  }
+  if (mPreviewing)
+  {
+    return;
+  }
+
+  // a press in the playing direction speeds up, the other direction starts over at normal speed
+  const bool wBackward = direction < 0;
+  const bool wReversing = mReversePlayer->isRunning() || mPlayer->isPlayingBackward();
+  const bool wSameDirection = wBackward ? wReversing : mPlaying && !wReversing;
+  mShuttleStep = wSameDirection ? std::min(mShuttleStep + 1, sShuttleRates.size() - 1) : 0;
+  const double wRate = sShuttleRates[mShuttleStep];
+
+  stopLoop();
+  loadKeyframes(); // the keyframe playback and the reverse gops start on them
+  mView->setSpeed(wRate);
+  mReversePlayer->setRate(wRate);
+  if (!wBackward)
+  {
+    mPlayer->setPlaybackRate(wRate); // the player picks the decode strategy of the rate
+    if (!wSameDirection)
+    {
+      play();
+    }
+    return;
+  }
+
+  if (wRate <= mSettings.mKeyframeRate)
+  {
+    mPlayer->setPlaybackRate(wRate);
+    if (!mReversePlayer->isRunning())
+    {
+      reversePlay();
+    }
+    showReverseHealth();
+    return;
+  }
+
+  // the gops can not be decoded this fast, the keyframes are enough to follow the picture
+  stopReverse();
+  mPlayer->playBackward(wRate);
+  mPlaying = true;
+  mView->onPlay();
+  SetThreadExecutionState(ES_CONTINUOUS | ES_DISPLAY_REQUIRED | ES_SYSTEM_REQUIRED);
+}
+
+void MediaPlayer::toggleGrid()
+{
+  if (mPreviewing || mPlaylist.empty())
+  {
+    return;
+  }
+  switch (mGridSize)
+  {
+    case 0:
+      mGridSize = 4;
+      mGridReturnUrl = mPlaylist.current();
+      break;
+    case 4:
+      mGridSize = 9;
+      break;
+    case 9:
+      mGridSize = 16;
+      break;
+    default:
+      closeGrid();
+      if (mPlaylist.current() != mGridReturnUrl)
+      {
+        // paged on meanwhile, the player follows the list to the first tile
+        mLoadPosition.reset();
+        mPlayer->setVideo(mPlaylist.current());
+        dropSpeculations();
+        mSequenceMap.clear();
+        mSelectedSequence = nullptr;
+        mView->setSequences(mSequenceMap);
+      }
+      mView->setCurrentVideo(static_cast<int>(mPlaylist.viewIndexOfCurrent()));
+      prepareNext();
+      return;
+  }
+  showGrid();
+}
+
+void MediaPlayer::showGrid()
+{
+  stop();
+  stopLoop();
+
+  // from the current entry on, in the playback order
+  std::vector<QUrl> wVideos = { mPlaylist.current() };
+  for (const QUrl& wUrl : mPlaylist.upcoming(mGridSize - 1))
+  {
+    wVideos.push_back(wUrl);
+  }
+  const int wHeight = std::max(2, mSettings.mGridTileHeight);
+  mGridPlayer->setBudget(mSettings.mGridDecodeBudget);
+  mGridPlayer->start(wVideos, mView->showGrid(wVideos.size()), QSize(wHeight * 16 / 9, wHeight));
+  mView->setCurrentVideo(static_cast<int>(mPlaylist.viewIndexOfCurrent()));
+  logStatusMessage(QString("Grid of %1 from %2").arg(wVideos.size()).arg(QFileInfo(Playlist::fileUrl(mPlaylist.current()).toLocalFile()).fileName()));
+}
+
+void MediaPlayer::closeGrid()
+{
+  if (mGridSize == 0)
+  {
+    return;
+  }
+  mGridSize = 0;
+  mGridPlayer->stop();
+  mView->hideGrid();
+}
+
+void MediaPlayer::promoteTile(const std::size_t index)
+{
+  const QUrl wUrl = mGridPlayer->video(index);
+  const VTime wPosition = mGridPlayer->position(index);
+  if (wUrl.isEmpty())
+  {
+    return;
+  }
+  closeGrid(); // the standby is left as it is, the hover opened this tile on it
+
+  // the player goes on from where the tile was
+  mPlaylist.setCurrentIndex(mPlaylist.indexOf(wUrl));
+  mPreviewing = false;
+  mLoadPosition = wPosition;
+  mPlayer->setVideo(mPlaylist.current());
+  mView->setCurrentVideo(static_cast<int>(mPlaylist.viewIndexOfCurrent()));
+  dropSpeculations();
+  mSequenceMap.clear();
+  mSelectedSequence = nullptr;
+  mView->setSequences(mSequenceMap);
+
+  play();
+}
+
+void MediaPlayer::showReverseHealth()
+{
+  if (!mReversePlayer->isRunning())
+  {
+    return;
+  }
+  // the reverse playback has no frame statistics, the indicator shows the strategy and the rate
+  PlaybackStatistics wStatistics;
+  wStatistics.mStrategy = DecodeStrategy::Reverse;
+  wStatistics.mRate = -mPlayer->playbackRate();
+  mView->setPlaybackHealth(wStatistics);
+}
+
+void MediaPlayer::stopReverse()
+{
+  if (mReversePlayer->isRunning())
+  {
+    mReversePlayer->stop();
+    mQos->setPlaying(false);
+  }
+}
+
+void MediaPlayer::loopPlay(const bool pingPong)
+{
+  if (mLoop)
+  {
+    const bool wPingPong = mPingPong;
+    stopLoop();
+    if (wPingPong == pingPong)
+    {
+      return;
+    }
+  }
+  if (mSelectedSequence == nullptr || mPreviewing || mGridSize > 0)
+  {
+    return;
+  }
+
+  pause();
+  mLoop = *mSelectedSequence;
+  mPingPong = pingPong;
+  mPlayer->setLoop(mLoop, !mPingPong);
+  if (mPingPong)
+  {
+    loadKeyframes();
+    preloadReverseLoop();
+  }
+  setPosition(mLoop->first);
+  play();
+  logStatusMessage(QString("Looping %1 - %2%3").arg(mLoop->first.toString(), mLoop->second.toString(), mPingPong ? " back and forth" : ""));
+}
+
+void MediaPlayer::stopLoop()
+{
+  if (!mLoop)
+  {
+    return;
+  }
+  mLoop.reset();
+  mPlayer->setLoop(std::nullopt);
+  mReversePlayer->stop(); // the preloaded backward pass too
+  mQos->setPlaying(mPlayer->isPlaying());
+  prepareNext(); // the standby held the start of the loop
+}
+
+void MediaPlayer::prepareSeekTargets()
+{
+  if (!mSettings.mPredecodeSeeks || mPreviewing)
+  {
+    mSeekTargets->clear();
+    return;
+  }
+  // at the size of the video, the player's own frame replaces it without a jump in the scale
+  // right after the load the sink has seen no frame yet, the metadata knows the size already
+  QSize wSize = mPlayer->videoDimensions();
+  if (wSize.isEmpty())
+  {
+    wSize = mPlayer->getMetadata().value(QMediaMetaData::Resolution).toSize();
+  }
+  mSeekTargets->prepare(Playlist::fileUrl(mPlaylist.current()), wSize, mPlayer->getPosition(), mPlayer->getDuration());
+}
+
+void MediaPlayer::preloadReverseLoop()
+{
+  mReversePlayer->preload(Playlist::fileUrl(mPlaylist.current()), mLoop->second, mLoop->first, frameRate());
+}
+
+double MediaPlayer::frameRate() const
+{
+  return mPlayer->getMetadata().value(QMediaMetaData::VideoFrameRate).toDouble();
+}
+
 void MediaPlayer::mark(const bool isCancel)
 {
+  if (mPreviewing || mGridSize > 0)
+  {
+    return; // positions of the preview are not positions of the source, the grid has none
+  }
+
   if (isCancel)
   {
     mEditedSequence = Sequence{ VTime(0), VTime(0) };
@@ -437,6 +965,7 @@ void MediaPlayer::mark(const bool isCancel)
     }
 
     mSequenceMap[mEditedSequence].mState = OperationState::Ready;
+    speculate(mEditedSequence); // most of the marked sequences are cut a few seconds later
 
     mEditedSequence = Sequence{ VTime(0), VTime(0) };
     mView->setSequences(mSequenceMap);
@@ -450,9 +979,9 @@ void MediaPlayer::logStatusMessage(const QString& msg)
 
 void MediaPlayer::cut(const CutMethod cutMethod)
 {
-  if (mSequenceMap.empty())
+  if (mSequenceMap.empty() || mGridSize > 0)
   {
-    return;
+    return; // paging the grid moves the current entry away from the video of the sequences
   }
 
   if (mSelectedSequence != nullptr)
@@ -463,6 +992,7 @@ void MediaPlayer::cut(const CutMethod cutMethod)
       return;
     }
 
+    wSequenceEntryIt->second.mFragmented = false; // the cuts writing fragments set it
     switch (cutMethod)
     {
       case CutMethod::Fast:
@@ -474,6 +1004,21 @@ void MediaPlayer::cut(const CutMethod cutMethod)
       case CutMethod::Loop:
         LoopCut(*wSequenceEntryIt);
         break;
+      case CutMethod::Ladder:
+        LadderCut(*wSequenceEntryIt);
+        break;
+      case CutMethod::TimeLapse:
+        TimeLapseCut(*wSequenceEntryIt);
+        break;
+      case CutMethod::Sized:
+        SizedCut(*wSequenceEntryIt);
+        break;
+      case CutMethod::Animation:
+        AnimationCut(*wSequenceEntryIt);
+        break;
+      case CutMethod::Frames:
+        FramesCut(*wSequenceEntryIt);
+        break;
     }
   }
   else
@@ -485,6 +1030,7 @@ void MediaPlayer::cut(const CutMethod cutMethod)
         continue;
       }
 
+      wSequenceEntry.second.mFragmented = false;
       switch (cutMethod)
       {
         case CutMethod::Fast:
@@ -496,6 +1042,21 @@ void MediaPlayer::cut(const CutMethod cutMethod)
         case CutMethod::Loop:
           LoopCut(wSequenceEntry);
         break;
+        case CutMethod::Ladder:
+          LadderCut(wSequenceEntry);
+          break;
+        case CutMethod::TimeLapse:
+          TimeLapseCut(wSequenceEntry);
+          break;
+        case CutMethod::Sized:
+          SizedCut(wSequenceEntry);
+          break;
+        case CutMethod::Animation:
+          AnimationCut(wSequenceEntry);
+          break;
+        case CutMethod::Frames:
+          FramesCut(wSequenceEntry);
+          break;
       }
     }
   }
@@ -503,519 +1064,1029 @@ void MediaPlayer::cut(const CutMethod cutMethod)
 
 void MediaPlayer::onVideoLoaded()
 { 
+  if (mPreviewing)
+  {
+    setPosition(mLoadPosition.value_or(VTime(0)));
+    mLoadPosition.reset();
+    play();
+    return;
+  }
+
   const QFileInfo fileInfo(mPlaylist.current().toLocalFile());
   const QString info(fileInfo.completeBaseName() + " - " + QString::number(mPlayer->getMetadata().value(QMediaMetaData::Resolution).value<QSize>().width()) + " x " + QString::number(mPlayer->getMetadata().value(QMediaMetaData::Resolution).value<QSize>().height()));
   mView->setInfo(info);
   mView->setCurrentVideo(static_cast<int>(mPlaylist.viewIndexOfCurrent()));
 
-  setPosition(VTime(0));
+  setPosition(mLoadPosition.value_or(entryStart()));
+  mLoadPosition.reset();
   
   if (mSettings.mAutoPlay)
   {
     play();
   }
+
+  prepareNext(); // after the current one, the two loads would only slow down each other
+  prepareSeekTargets();
+}
+
+VTime MediaPlayer::entryStart() const
+{
+  const std::optional<Sequence> wRange = Playlist::range(mPlaylist.current());
+  return wRange ? wRange->first : VTime(0);
+}
+
+void MediaPlayer::loadKeyframes()
+{
+  // only when the user starts to move around, listing the keyframes reads the whole file
+  if (!mPreviewing && mGridSize == 0)
+  {
+    mKeyframes->load(Playlist::fileUrl(mPlaylist.current()));
+  }
+}
+
+void MediaPlayer::prepareNext()
+{
+  if (mLoop)
+  {
+    return; // the standby pre-rolls the start of the loop
+  }
+
+  // the order may have been shuffled or filtered since, the upcoming entry is asked for every time
+  const QUrl wUpcoming = mSettings.mPrewarmNext ? mPlaylist.upcoming() : QUrl();
+  mPlayer->prepare(wUpcoming != mPlaylist.current() ? wUpcoming : QUrl());
+
+  // a new prefetch replaces the one of the old order, the range entries of a file are read once
+  std::vector<QUrl> wFiles;
+  for (const QUrl& wUrl : mPlaylist.upcoming(static_cast<std::size_t>(std::max(0, mSettings.mPrefetchCount))))
+  {
+    const QUrl wFileUrl = Playlist::fileUrl(wUrl);
+    if (std::find(wFiles.begin(), wFiles.end(), wFileUrl) == wFiles.end())
+    {
+      wFiles.push_back(wFileUrl);
+    }
+  }
+  constexpr qint64 wMB = 1024 * 1024;
+  mPrefetcher->prefetch(wFiles, std::max(0, mSettings.mPrefetchHeadMB) * wMB, std::max(0, mSettings.mPrefetchBudgetMB) * wMB);
 }
 
 void MediaPlayer::onVideoEnded()
 {
+  if (mPreviewing)
+  {
+    // the player only knows the fragments written until the file was opened, reopen it while the cut is still growing
+    auto wSequenceEntryIt = mSequenceMap.find(mPreviewSequence);
+    const VTime wLoadedDuration = mPlayer->getDuration();
+    const bool wGrowing = wSequenceEntryIt != mSequenceMap.end()
+      && (wSequenceEntryIt->second.mState == OperationState::Processing
+          || (wSequenceEntryIt->second.mState == OperationState::Succeeded && wLoadedDuration + VTime(100) < wSequenceEntryIt->second.mProcessTimer));
+    if (wGrowing)
+    {
+      mLoadPosition = wLoadedDuration;
+      mPlayer->setVideo(QUrl::fromLocalFile(wSequenceEntryIt->second.mFilePath));
+      return;
+    }
+
+    stopPreview();
+    return;
+  }
+
   // TODO add loop|next|stop Settings
   next();
 }
 
 void MediaPlayer::FastCut(SequenceEntry& sequenceEntry)
+{
+  if (promoteSpeculation(sequenceEntry))
+  {
+    return;
+  }
+
+  const QString wVideoPath = mPlaylist.current().toLocalFile();
+
+  const QString wCutFilePath = cutFilePath(wVideoPath, sequenceEntry.first, ".mp4");
+  sequenceEntry.second.mFilePath = wCutFilePath;
+
+  submitSequenceJob(sequenceEntry.first, mPlaylist.current(), "Fast cut", fastCutArguments(wVideoPath, sequenceEntry.first, wCutFilePath), wCutFilePath);
+}
+
+void MediaPlayer::PreciseCut(SequenceEntry& sequenceEntry, const QStringList& rateArguments)
 {
   const VTime wStartTime = sequenceEntry.first.first;
   const VTime wEndTime = sequenceEntry.first.second;
-  const QString& wVideoPath = mPlaylist.current().toLocalFile();
+  const QString wVideoPath = mPlaylist.current().toLocalFile();
 
-  const QString wCutFilePath = mOutputRootDirectory + utils::prettifyFileName(QFileInfo(wVideoPath).completeBaseName()) + "." + wStartTime.toString('.') + "." + QString::number((wEndTime - wStartTime).ms()) + ".mp4";
+  const QString wCutFilePath = cutFilePath(wVideoPath, sequenceEntry.first, ".mp4");
   sequenceEntry.second.mFilePath = wCutFilePath;
+  sequenceEntry.second.mFragmented = mSettings.mFragmentedOutput;
 
-  mProcesses.push_back(std::make_unique<QProcess>(this));
-  QProcess* wProcess = mProcesses.back().get();
+  const FilterChain wFilterChain = filterChain();
 
-  connect(wProcess, &QProcess::started, this, [ & ]() {
-    sequenceEntry.second.mState = OperationState::Processing;
-    mView->setSequences(mSequenceMap);
-    logStatusMessage("Fast cut started");
-  });
+  QStringList args = { "-hide_banner", "-loglevel", "info", "-y" };
+  if (mGpuEncode)
+  {
+    args.append({ "-hwaccel", "cuda" });
+  }
 
-  connect(wProcess, &QProcess::finished, this, [ & ](int exitCode, QProcess::ExitStatus exitStatus) {
-    sequenceEntry.second.mState = exitCode == 0 ? OperationState::Succeeded : OperationState::Failed;
-    mView->setSequences(mSequenceMap);
-    logStatusMessage(QString("Fast cut ") + (exitCode == 0 ? "succeeded" : "failed"));
-  });
+  args.append(inputArguments(wVideoPath, wStartTime, wEndTime));
+  args.append(wFilterChain.arguments());
+
+  args.append({ "-c:v", mGpuEncode ? "h264_nvenc" : "libx264" }); // GPU or CPU
+  args.append(threadArguments());
+  args.append(rateArguments);
+  args.append(fragmentArguments());
+  args.append({ "-c:a", "aac", wCutFilePath });
+
+  submitSequenceJob(sequenceEntry.first, mPlaylist.current(), "Precise cut" + encoderDescription(), args, wCutFilePath, wFilterChain.speed());
+}
+
+void MediaPlayer::LoopCut(SequenceEntry& sequenceEntry)
+{
+  const Sequence wSequence = sequenceEntry.first;
+  const QUrl wVideoUrl = mPlaylist.current();
+
+  const QString wLoopFilePath = cutFilePath(wVideoUrl.toLocalFile(), wSequence, ".loop.mp4");
+  const unsigned loopCount = mView->getLoopCount();
+  sequenceEntry.second.mFilePath = wLoopFilePath;
+  const FilterChain wFilterChain = filterChain();
+
+  const QString wCutFilePath = QFileInfo(wLoopFilePath).absolutePath() + QFileInfo(wLoopFilePath).completeBaseName() + "_cut.mp4";
+  const QString wReversedFilePath = QFileInfo(wCutFilePath).absolutePath() + QFileInfo(wCutFilePath).completeBaseName() + "_reversed.mp4";
 
-  connect(wProcess, &QProcess::readyReadStandardOutput, this, [ &, this, wProcess]() {
-    QString output = QString::fromLocal8Bit(wProcess->readAllStandardOutput());
-    if (!output.isEmpty())
+  // the steps depend on each other, every step is submitted by the successful previous one
+  auto wMerge = [this, wSequence, wVideoUrl, wCutFilePath, wReversedFilePath, wLoopFilePath, loopCount]() {
+    const QString wConcatFilePath = utils::uniqueFileName(mOutputRootDirectory + "concat.txt");
     {
-      QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-      QRegularExpressionMatchIterator i = re.globalMatch(output);
-      while (i.hasNext())
+      std::ofstream ofs(wConcatFilePath.toStdString());
+      for (unsigned n = 0; n < loopCount; ++n)
       {
-        QRegularExpressionMatch match = i.next();
-        if (match.hasMatch())
-        {
-          const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-          const VTime time = VTime(timeStr);
-          const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-          if (time < duration)
-          {
-            sequenceEntry.second.mProcessTimer = time;
-          }
-          else
-          {
-            sequenceEntry.second.mProcessTimer = duration;
-          }
-          mView->setSequences(mSequenceMap);
-        }
+        ofs << "file " << (wCutFilePath.toStdString()) << "\n";
+        ofs << "file " << (wReversedFilePath.toStdString()) << "\n";
       }
     }
-    });
-  connect(wProcess, &QProcess::readyReadStandardError, this, [ &, this, wProcess]() {
-    QString error = QString::fromLocal8Bit(wProcess->readAllStandardError());
-    if (!error.isEmpty())
-    {
-        QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-        QRegularExpressionMatchIterator i = re.globalMatch(error);
-        while (i.hasNext())
-        {
-          QRegularExpressionMatch match = i.next();
-          if (match.hasMatch())
-          {
-            const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-            const VTime time = VTime(timeStr);
-            const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-            if (time < duration)
-            {
-              sequenceEntry.second.mProcessTimer = time;
-            }
-            else
-            {
-              sequenceEntry.second.mProcessTimer = duration;
-            }
-            mView->setSequences(mSequenceMap);
-          }
+
+    const QStringList wArguments = { "-f", "concat", "-safe", "0", "-i", wConcatFilePath, "-c", "copy", wLoopFilePath, "-y" };
+    submitSequenceJob(wSequence, wVideoUrl, "Merger", wArguments, wLoopFilePath, 1.0, [this, wSequence, wVideoUrl, wConcatFilePath, wCutFilePath, wReversedFilePath](bool succeeded) {
+      finishSequence(wSequence, wVideoUrl, "Loop cut", succeeded);
+      QFile::remove(wConcatFilePath);
+      QFile::remove(wCutFilePath);
+      QFile::remove(wReversedFilePath);
+      }, wCutFilePath); // the reversed part is next to it
+  };
+
+  auto wReverse = [this, wSequence, wVideoUrl, wCutFilePath, wReversedFilePath, wMerge]() {
+    QStringList wArguments = { "-i", wCutFilePath };
+    wArguments.append(FilterChain().add(Filter::reverse()).arguments());
+    wArguments.append(threadArguments());
+    wArguments.append({ wReversedFilePath, "-y" });
+    submitSequenceJob(wSequence, wVideoUrl, "Reverser", wArguments, wReversedFilePath, 1.0, [this, wSequence, wVideoUrl, wMerge](bool succeeded) {
+      if (!succeeded)
+      {
+        finishSequence(wSequence, wVideoUrl, "Reverser", false);
+        return;
       }
+      logStatusMessage("Reverser succeeded");
+      wMerge();
+      }, wCutFilePath);
+  };
+
+  QStringList args = { "-hide_banner", "-loglevel", "info", "-y" };
+  if (mGpuEncode)
+  {
+    args.append({ "-hwaccel", "cuda" });
+  }
+
+  args.append(inputArguments(wVideoUrl.toLocalFile(), wSequence.first, wSequence.second));
+  args.append(wFilterChain.arguments());
+  args.append({ "-c:v", mGpuEncode ? "h264_nvenc" : "libx264" }); // GPU or CPU
+  args.append(threadArguments());
+  args.append({ "-c:a", "aac", wCutFilePath });
+
+  submitSequenceJob(wSequence, wVideoUrl, "Loop cut" + encoderDescription(), args, wCutFilePath, wFilterChain.speed(), [this, wSequence, wVideoUrl, wReverse](bool succeeded) {
+    if (!succeeded)
+    {
+      finishSequence(wSequence, wVideoUrl, "Precise cut", false);
+      return;
     }
+    logStatusMessage("Precise cut succeeded");
+    wReverse();
     });
+}
+
+void MediaPlayer::LadderCut(SequenceEntry& sequenceEntry)
+{
+  const std::vector<int>& wHeights = mSettings.mRenditionHeights;
+  if (wHeights.empty())
+  {
+    logStatusMessage("Ladder cut: no renditions set");
+    return;
+  }
+
+  const VTime wStartTime = sequenceEntry.first.first;
+  const VTime wEndTime = sequenceEntry.first.second;
+  const QString wVideoPath = mPlaylist.current().toLocalFile();
+
+  auto wRenditionFilePath = [&](int height) { return cutFilePath(wVideoPath, sequenceEntry.first, "." + QString::number(height) + "p.mp4"); };
+  sequenceEntry.second.mFilePath = wRenditionFilePath(wHeights.front()); // the first rung is the one opened on double click
+  sequenceEntry.second.mFragmented = mSettings.mFragmentedOutput;
+
+  // decode and filter once, split the frames to the per rendition scalers
+  const FilterChain wFilterChain = filterChain();
 
-  QStringList args;
+  QStringList args = { "-hide_banner", "-loglevel", "info", "-y" };
+  if (mGpuEncode)
   {
-    args = { "-ss", wStartTime.toString(),
-             "-i", wVideoPath,
-             "-t", (wEndTime - wStartTime).toString(),
-             "-async", "1",
-             "-vcodec", "copy",
-             "-acodec", "copy",
-             "-avoid_negative_ts", "1",
-             wCutFilePath, "-y" };
+    args.append({ "-hwaccel", "cuda" });
   }
-  wProcess->start(mFFMpegPath, args);
+  args.append(inputArguments(wVideoPath, wStartTime, wEndTime));
+  const bool wAudioFiltered = mPlayer->hasAudio() && !wFilterChain.audioGraph().isEmpty();
+  args.append({ "-filter_complex", wFilterChain.complexGraph(wHeights, wAudioFiltered) });
+  for (size_t i = 0; i < wHeights.size(); ++i)
+  {
+    args.append({ "-map", QString("[v%1]").arg(i), "-map", wAudioFiltered ? QString("[a%1]").arg(i) : QString("0:a?") });
+    args.append({ "-c:v", mGpuEncode ? "h264_nvenc" : "libx264" });
+    args.append(threadArguments());
+    args.append(fragmentArguments());
+    args.append({ "-c:a", "aac", wRenditionFilePath(wHeights[i]) });
+  }
+
+  // ffmpeg reports a single time for all outputs of the process, it is the slowest rendition, so
+  // the per rendition progress is already rolled up into the sequence timer
+  submitSequenceJob(sequenceEntry.first, mPlaylist.current(), QString("Ladder cut of %1 renditions").arg(wHeights.size()) + encoderDescription(), args, sequenceEntry.second.mFilePath, wFilterChain.speed());
 }
 
-void MediaPlayer::PreciseCut(SequenceEntry& sequenceEntry)
+void MediaPlayer::TimeLapseCut(SequenceEntry& sequenceEntry)
 {
   const VTime wStartTime = sequenceEntry.first.first;
   const VTime wEndTime = sequenceEntry.first.second;
-  const QString& wVideoPath = mPlaylist.current().toLocalFile();
+  const QString wVideoPath = mPlaylist.current().toLocalFile();
 
-  const QString wCutFilePath = mOutputRootDirectory + utils::prettifyFileName(QFileInfo(wVideoPath).completeBaseName()) + "." + wStartTime.toString('.') + "." + QString::number((wEndTime - wStartTime).ms()) + ".mp4";
+  const QString wCutFilePath = cutFilePath(wVideoPath, sequenceEntry.first, ".timelapse.mp4");
   sequenceEntry.second.mFilePath = wCutFilePath;
 
-  QStringList args;
+  // only keyframes reach the decoder, the work depends on the output frame count, not on the range length
+  FilterChain wFilterChain = filterChain();
+  wFilterChain.add(Filter::decimate(mSettings.mTimeLapseKeyframeStep))
+              .add(Filter::speed(mSettings.mTimeLapseSpeed))
+              .add(Filter::fps(mSettings.mTimeLapseFps));
+
+  QStringList args = { "-hide_banner", "-loglevel", "info", "-y" };
+  if (mGpuEncode)
   {
-    args = { "-hide_banner", "-loglevel", "info", "-y" };
-    if (mGpuEncode)
+    args.append({ "-hwaccel", "cuda" });
+  }
+  args.append({ "-discard", "nokey",      // non key packets are dropped by the demuxer
+                "-skip_frame", "nokey",   // and the decoder would skip them anyway
+                "-ss", wStartTime.toString(),
+                "-t", (wEndTime - wStartTime).toString(),
+                "-i", wVideoPath,
+                "-vf", wFilterChain.videoGraph(),
+                "-an" });
+  args.append({ "-c:v", mGpuEncode ? "h264_nvenc" : "libx264" });
+  args.append(threadArguments());
+  args.append(fragmentArguments());
+  args.append(wCutFilePath);
+
+  submitSequenceJob(sequenceEntry.first, mPlaylist.current(), QString("Time-lapse cut at %1x").arg(mSettings.mTimeLapseSpeed), args, wCutFilePath, wFilterChain.speed());
+}
+
+void MediaPlayer::SizedCut(SequenceEntry& sequenceEntry)
+{
+  const Sequence wSequence = sequenceEntry.first;
+  const QUrl wVideoUrl = mPlaylist.current();
+  const qint64 wAudioBitrate = 128000;
+
+  sequenceEntry.second.mState = OperationState::Processing;
+  sequenceEntry.second.mProcessTimer = VTime(0);
+  mView->setSequences(mSequenceMap);
+
+  SizePredictor* wPredictor = new SizePredictor(mFFMpegPath, mScheduler.get(), this);
+  wPredictor->setGpuEncode(mGpuEncode);
+  const QString wVideoGraph = filterChain().videoGraph();
+  wPredictor->setFilterArguments(wVideoGraph.isEmpty() ? QStringList() : QStringList{ "-vf", wVideoGraph });
+
+  // the sequence may be gone or the video changed by the time the samples are done
+  connect(wPredictor, &SizePredictor::predicted, this, [this, wPredictor, wSequence, wVideoUrl, wAudioBitrate](double crf, qint64 predictedBytes) {
+    wPredictor->deleteLater();
+    auto wSequenceEntryIt = mSequenceMap.find(wSequence);
+    if (wSequenceEntryIt == mSequenceMap.end() || mPlaylist.current() != wVideoUrl)
+    {
+      return;
+    }
+
+    logStatusMessage(QString("Sized cut: crf %1, predicted %2 MB").arg(crf, 0, 'f', 1).arg(predictedBytes / (1024.0 * 1024.0), 0, 'f', 1));
+    QStringList wRateArguments = wPredictor->rateArguments(crf);
+    wRateArguments.append({ "-b:a", QString::number(wAudioBitrate) });
+    PreciseCut(*wSequenceEntryIt, wRateArguments);
+    });
+  connect(wPredictor, &SizePredictor::failed, this, [this, wPredictor, wSequence, wVideoUrl](const QString& reason) {
+    wPredictor->deleteLater();
+    logStatusMessage(QString("Sized cut failed: %1").arg(reason));
+    auto wSequenceEntryIt = mSequenceMap.find(wSequence);
+    if (wSequenceEntryIt != mSequenceMap.end() && mPlaylist.current() == wVideoUrl)
     {
-      args.append({ "-hwaccel", "cuda" });
+      wSequenceEntryIt->second.mState = OperationState::Failed;
+      mView->setSequences(mSequenceMap);
     }
+    });
+
+  logStatusMessage(QString("Sized cut: sampling for %1 MB").arg(mSettings.mTargetSizeMB));
+  wPredictor->predict(wVideoUrl.toLocalFile(), wSequence.first, wSequence.second, static_cast<qint64>(mSettings.mTargetSizeMB) * 1024 * 1024, wAudioBitrate);
+}
+
+void MediaPlayer::AnimationCut(SequenceEntry& sequenceEntry)
+{
+  const VTime wStartTime = sequenceEntry.first.first;
+  const VTime wEndTime = sequenceEntry.first.second;
+  const QString wVideoPath = mPlaylist.current().toLocalFile();
+  const bool wGif = mSettings.mAnimationFormat == Settings::AnimationFormat::Gif;
+
+  const QString wCutFilePath = cutFilePath(wVideoPath, sequenceEntry.first, wGif ? ".gif" : ".webp");
+  sequenceEntry.second.mFilePath = wCutFilePath;
+
+  FilterChain wFilterChain = filterChain();
+  wFilterChain.add(Filter::scale(mSettings.mAnimationWidth, -2))
+              .add(Filter::fps(mSettings.mAnimationFps));
+
+  QStringList args = { "-hide_banner", "-loglevel", "info", "-y" };
+  args.append(inputArguments(wVideoPath, wStartTime, wEndTime));
+  if (wGif)
+  {
+    // one decode, the palette is generated and applied on the two branches of a split, the input ends with the range
+    args.append({ "-filter_complex", wFilterChain.paletteGraph(), "-map", "[v]", "-loop", "0" });
+  }
+  else
+  {
+    // webp is not palette based, the plain chain is enough
+    args.append({ "-vf", wFilterChain.videoGraph(), "-c:v", "libwebp_anim", "-loop", "0", "-quality", "75" });
+  }
+  args.append(threadArguments());
+  args.append({ "-an", wCutFilePath });
+
+  submitSequenceJob(sequenceEntry.first, mPlaylist.current(), QString("Animation cut (%1)").arg(wGif ? "gif" : "webp"), args, wCutFilePath, wFilterChain.speed());
+}
+
+void MediaPlayer::FramesCut(SequenceEntry& sequenceEntry)
+{
+  const VTime wStartTime = sequenceEntry.first.first;
+  const VTime wEndTime = sequenceEntry.first.second;
+  const QString wVideoPath = mPlaylist.current().toLocalFile();
+
+  // the directory is opened on double click
+  const QString wDirectoryPath = cutFilePath(wVideoPath, sequenceEntry.first, ".frames");
+  sequenceEntry.second.mFilePath = wDirectoryPath;
+  QDir().mkpath(wDirectoryPath);
+
+  FilterChain wFilterChain = filterChain();
+  wFilterChain.add(Filter::decimate(mSettings.mFrameStep));
+
+  // ffmpeg decodes and compresses the images on its own threads, outside of the UI process
+  QStringList args = { "-hide_banner", "-loglevel", "info", "-y" };
+  if (mGpuEncode)
+  {
+    args.append({ "-hwaccel", "cuda" });
+  }
+  args.append(inputArguments(wVideoPath, wStartTime, wEndTime));
+  const QString wVideoGraph = wFilterChain.videoGraph(); // empty for every frame without filters, ffmpeg rejects an empty -vf
+  if (!wVideoGraph.isEmpty())
+  {
+    args.append({ "-vf", wVideoGraph });
+  }
+  args.append({ "-vsync", "vfr", "-an" }); // the dropped frames leave no duplicates behind
+  switch (mSettings.mImageFormat)
+  {
+    case Settings::ImageFormat::Png:
+      break;
+    case Settings::ImageFormat::Jpeg:
+      args.append({ "-q:v", "2" });
+      break;
+    case Settings::ImageFormat::WebP:
+      args.append({ "-c:v", "libwebp", "-quality", "90" });
+      break;
+  }
+  args.append(threadArguments());
+  args.append(QDir(wDirectoryPath).filePath("%06d" + imageSuffix()));
+
+  submitSequenceJob(sequenceEntry.first, mPlaylist.current(), QString("Frame export of every %1. frame").arg(std::max(1, mSettings.mFrameStep)), args, wDirectoryPath, wFilterChain.speed());
+}
+
+FilterChain MediaPlayer::filterChain() const
+{
+  FilterChain wChain;
+  if (mDeinterlace)
+  {
+    wChain.add(Filter::deinterlace());
+  }
+  if (mSettings.mCrop.isValid())
+  {
+    wChain.add(Filter::crop(mSettings.mCrop));
+  }
+  if (mSettings.mOutputHeight > 0)
+  {
+    wChain.add(Filter::scale(-2, mSettings.mOutputHeight));
+  }
+  if (mSettings.mOutputSpeed > 0.0)
+  {
+    wChain.add(Filter::speed(mSettings.mOutputSpeed));
+  }
+  if (mSettings.mOutputFps > 0.0)
+  {
+    wChain.add(Filter::fps(mSettings.mOutputFps));
+  }
+  if (mSettings.mNormalizeAudio)
+  {
+    wChain.add(Filter::audioNormalize());
+  }
+  return wChain;
+}
+
+QStringList MediaPlayer::inputArguments(const QString& videoPath, const VTime& startTime, const VTime& endTime) const
+{
+  // the range is trimmed on the input, so the filters and every output of the process see only the range:
+  // ffmpeg seeks to the keyframe before the start and drops the decoded frames up to it
+  return { "-ss", startTime.toString(),
+           "-t", (endTime - startTime).toString(),
+           "-i", videoPath };
+}
+
+QStringList MediaPlayer::fragmentArguments() const
+{
+  if (!mSettings.mFragmentedOutput)
+  {
+    return {};
+  }
+
+  // a self contained fragment for every second of output, the file is playable while it is written
+  return { "-force_key_frames", "expr:gte(t,n_forced*1)",
+           "-movflags", "+frag_keyframe+empty_moov+default_base_moof",
+           "-frag_duration", "1000000" };
+}
+
+QString MediaPlayer::cutFilePath(const QString& videoPath, const Sequence& sequence, const QString& suffix) const
+{
+  return mOutputRootDirectory + utils::prettifyFileName(QFileInfo(videoPath).completeBaseName()) + "." + sequence.first.toString('.') + "." + QString::number((sequence.second - sequence.first).ms()) + suffix;
+}
+
+QStringList MediaPlayer::fastCutArguments(const QString& videoPath, const Sequence& sequence, const QString& outputPath) const
+{
+  return { "-ss", sequence.first.toString(),
+           "-i", videoPath,
+           "-t", (sequence.second - sequence.first).toString(),
+           "-async", "1",
+           "-vcodec", "copy",
+           "-acodec", "copy",
+           "-avoid_negative_ts", "1",
+           outputPath, "-y" };
+}
+
+QString MediaPlayer::encoderDescription() const
+{
+  return QString(" on ") + (mGpuEncode ? "GPU" : "CPU") + (mDeinterlace ? " with deinterlacing" : "");
+}
+
+qint64 MediaPlayer::rangeBytes(const QString& videoPath, const VTime& videoDuration, const Sequence& sequence) const
+{
+  if (videoDuration.ms() <= 0)
+  {
+    return 0;
+  }
+  const double wFraction = std::clamp(static_cast<double>((sequence.second - sequence.first).ms()) / videoDuration.ms(), 0.0, 1.0);
+  return static_cast<qint64>(QFileInfo(videoPath).size() * wFraction);
+}
+
+QStringList MediaPlayer::threadArguments() const
+{
+  return { "-threads", Job::sThreadCount }; // the scheduler fills in the share of the job from the thread budget
+}
+
+QString MediaPlayer::imageSuffix() const
+{
+  switch (mSettings.mImageFormat)
+  {
+    case Settings::ImageFormat::Jpeg:
+      return ".jpg";
+    case Settings::ImageFormat::WebP:
+      return ".webp";
+    case Settings::ImageFormat::Png:
+    default:
+      return ".png";
+  }
+}
+
+SequenceState* MediaPlayer::sequenceState(const Sequence& sequence, const QUrl& videoUrl)
+{
+  // the sequences are kept for the current video only, and they may have been deleted since the job was submitted
+  if (mPlaylist.current() != videoUrl)
+  {
+    return nullptr;
+  }
 
-    const VTime wPreloadTime(1000);
-    if (wStartTime >= wPreloadTime)
+  auto wSequenceEntryIt = mSequenceMap.find(sequence);
+  return wSequenceEntryIt == mSequenceMap.end() ? nullptr : &wSequenceEntryIt->second;
+}
+
+void MediaPlayer::finishSequence(const Sequence& sequence, const QUrl& videoUrl, const QString& name, const bool succeeded)
+{
+  if (SequenceState* wState = sequenceState(sequence, videoUrl))
+  {
+    wState->mState = succeeded ? OperationState::Succeeded : OperationState::Failed;
+    mView->setSequences(mSequenceMap);
+  }
+  logStatusMessage(name + (succeeded ? " succeeded" : " failed"));
+}
+
+Job::Id MediaPlayer::submitSequenceJob(const Sequence& sequence, const QUrl& videoUrl, const QString& name, const QStringList& arguments, const QString& outputPath, const double timeScale, std::function<void(bool)> onFinished, const QString& inputPath)
+{
+  if (SequenceState* wState = sequenceState(sequence, videoUrl))
+  {
+    wState->mState = OperationState::Queued;
+    wState->mProcessTimer = VTime(0);
+    mView->setSequences(mSequenceMap);
+  }
+
+  Job wJob;
+  wJob.mName = name;
+  wJob.mProgram = mFFMpegPath;
+  wJob.mArguments = arguments;
+  wJob.mSourcePath = inputPath.isEmpty() ? videoUrl.toLocalFile() : inputPath;
+  wJob.mDestinationPath = outputPath;
+  wJob.mDuration = sequence.second - sequence.first;
+  wJob.mTimeScale = timeScale;
+  if (!inputPath.isEmpty())
+  {
+    // the intermediate is written already
+    wJob.mInputBytes = QFileInfo(inputPath).size();
+    wJob.mOutputBytes = wJob.mInputBytes;
+  }
+  else if (mPlaylist.current() == videoUrl && !mPreviewing)
+  {
+    // the output is assumed to be as big as the source range, cuts rarely raise the bitrate
+    wJob.mInputBytes = rangeBytes(wJob.mSourcePath, mPlayer->getDuration(), sequence);
+    wJob.mOutputBytes = wJob.mInputBytes;
+  }
+
+  JobHandlers wHandlers;
+  wHandlers.mStarted = [this, sequence, videoUrl, name]() {
+    if (SequenceState* wState = sequenceState(sequence, videoUrl))
     {
-      args.append({
-          "-ss", (wStartTime - wPreloadTime).toString(),
-          "-i", wVideoPath,
-          "-ss", wPreloadTime.toString(),
-        });
+      wState->mState = OperationState::Processing;
+      wState->mProcessTimer = VTime(0);
+      mView->setSequences(mSequenceMap);
     }
-    else
+    logStatusMessage(name + " started");
+  };
+  wHandlers.mProgress = [this, sequence, videoUrl](const VTime& time) {
+    if (SequenceState* wState = sequenceState(sequence, videoUrl))
     {
-      args.append({
-          "-i", wVideoPath,
-          "-ss", wStartTime.toString(),
-          "-t", (wEndTime - wStartTime).toString(),
-        });
+      wState->mProcessTimer = time;
+      mView->setSequences(mSequenceMap);
     }
-    args.append({ "-t", (wEndTime - wStartTime).toString() });
-    if (mDeinterlace)
+  };
+  wHandlers.mFinished = [this, sequence, videoUrl, name, onFinished](bool succeeded) {
+    if (onFinished)
     {
-      args.append({ "-vf", "yadif" });
+      onFinished(succeeded); // dependent steps decide about the final state themselves
+      return;
     }
+    finishSequence(sequence, videoUrl, name, succeeded);
+  };
+  return runJob(wJob, std::move(wHandlers));
+}
 
-    args.append({ "-c:v", mGpuEncode ? "h264_nvenc" : "libx264" }); // GPU or CPU
-    args.append({ "-c:a", "aac", wCutFilePath });
+Job::Id MediaPlayer::runJob(const Job& job, JobHandlers handlers)
+{
+  // the scheduler starts the job from the event loop, the handlers are in place by then
+  const Job::Id wId = mScheduler->submit(job);
+  mJobHandlers.emplace(wId, std::move(handlers));
+  return wId;
+}
+
+void MediaPlayer::captureFrame()
+{
+  // the sink already holds the decoded frame, only the conversion and the compression are left
+  const QVideoFrame wFrame = mPlayer->currentFrame();
+  if (!wFrame.isValid() || mPreviewing || mGridSize > 0)
+  {
+    return;
   }
 
-  mProcesses.push_back(std::make_unique<QProcess>(this));
-  QProcess* wProcess = mProcesses.back().get();
-  connect(wProcess, &QProcess::started, this, [&]() {
-    sequenceEntry.second.mState = OperationState::Processing;
-    mView->setSequences(mSequenceMap);
-    logStatusMessage(QString("Precise cut started on ") + (mGpuEncode ? "GPU" : "CPU") + (mDeinterlace ? " with deinterlacing" : ""));
-    });
+  const QString wImagePath = utils::uniqueFileName(mOutputRootDirectory + utils::prettifyFileName(QFileInfo(mPlaylist.current().toLocalFile()).completeBaseName())
+                                                   + "." + mPlayer->getPosition().toString('.') + imageSuffix());
+  const int wQuality = mSettings.mImageFormat == Settings::ImageFormat::Png ? -1 : 90;
 
-  connect(wProcess, &QProcess::finished, this, [&](int exitCode, QProcess::ExitStatus exitStatus) {
-    sequenceEntry.second.mState = exitCode == 0 ? OperationState::Succeeded : OperationState::Failed;
-    mView->setSequences(mSequenceMap);
-    logStatusMessage(QString("Precise cut ") + (exitCode == 0 ? "succeeded" : "failed"));
+  mImagePool.start([this, wFrame, wImagePath, wQuality]() {
+    const bool wSaved = wFrame.toImage().save(wImagePath, nullptr, wQuality); // the format follows the suffix
+    QMetaObject::invokeMethod(this, [this, wSaved, wImagePath]() {
+      logStatusMessage(QString("Frame capture %1: %2").arg(wSaved ? "saved" : "failed", wImagePath));
+      }, Qt::QueuedConnection);
     });
+}
 
-  connect(wProcess, &QProcess::readyReadStandardOutput, this, [&, this, wProcess]() {
-    QString output = QString::fromLocal8Bit(wProcess->readAllStandardOutput());
-    if (!output.isEmpty())
+void MediaPlayer::batchCut(const bool precise)
+{
+  const std::vector<QUrl> wVideos = mPlaylist.getVideos();
+  if (wVideos.empty())
+  {
+    return;
+  }
+
+  // the range depends on the duration, the probes run in the background and every probed video is queued right away
+  DurationProber* wProber = new DurationProber(utils::ffprobePath(), this);
+  // the template gives many videos the same range, the playlist index keeps their outputs apart
+  auto wPending = std::make_shared<std::vector<QUrl>>(wVideos);
+  connect(wProber, &DurationProber::probed, this, [this, precise, wPending](const QUrl& url, const VTime& duration) {
+    const auto wIt = std::find(wPending->begin(), wPending->end(), url);
+    if (wIt == wPending->end())
     {
-      QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-      QRegularExpressionMatchIterator i = re.globalMatch(output);
-      while (i.hasNext()) {
-        QRegularExpressionMatch match = i.next();
-        if (match.hasMatch()) {
-          const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-          const VTime time = VTime(timeStr);
-          const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-          if (time < duration)
-          {
-            sequenceEntry.second.mProcessTimer = time;
-          }
-          else
-          {
-            sequenceEntry.second.mProcessTimer = duration;
-          }
-          mView->setSequences(mSequenceMap);
-        }
-      }
+      return;
     }
-    });
-  connect(wProcess, &QProcess::readyReadStandardError, this, [&, this, wProcess]() {
-    QString error = QString::fromLocal8Bit(wProcess->readAllStandardError());
-    if (!error.isEmpty())
+    const int wIndex = static_cast<int>(wIt - wPending->begin()) + 1;
+    *wIt = QUrl(); // a video listed twice takes the next index
+    if (duration.ms() <= 0)
     {
-      QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-      QRegularExpressionMatchIterator i = re.globalMatch(error);
-      while (i.hasNext()) {
-        QRegularExpressionMatch match = i.next();
-        if (match.hasMatch()) {
-          const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-          const VTime time = VTime(timeStr);
-          const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-          if (time < duration)
-          {
-            sequenceEntry.second.mProcessTimer = time;
-          }
-          else
-          {
-            sequenceEntry.second.mProcessTimer = duration;
-          }
-          mView->setSequences(mSequenceMap);
-        }
-      }
+      logStatusMessage(QString("Batch cut: no duration for %1").arg(url.toLocalFile()));
+      return;
     }
+    submitBatchJob(url, wIndex, duration, precise);
     });
+  connect(wProber, &DurationProber::finished, wProber, &QObject::deleteLater);
 
-  wProcess->start(mFFMpegPath, args);
+  logStatusMessage(QString("Batch cut of %1 videos queued").arg(wVideos.size()));
+  wProber->probe(wVideos);
 }
 
-void MediaPlayer::LoopCut(SequenceEntry& sequenceEntry)
+void MediaPlayer::submitBatchJob(const QUrl& videoUrl, const int index, const VTime& duration, const bool precise)
 {
-  const VTime wStartTime = sequenceEntry.first.first;
-  const VTime wEndTime = sequenceEntry.first.second;
+  const VTime wLength = std::min(VTime(static_cast<qint64>(mSettings.mBatchLength * 1000.0)), duration);
+  if (wLength.ms() <= 0)
+  {
+    return;
+  }
 
-  const QString wPrettyFileName = utils::prettifyFileName(QFileInfo(mPlaylist.current().toLocalFile()).completeBaseName());
-  const QString wLengthStr = QString::number((wEndTime - wStartTime).ms());
-  const QString wStartStr = wStartTime.toString('.');
-  const QString wLoopFilePath = mOutputRootDirectory + wPrettyFileName + "." + wStartStr + "." + wLengthStr + ".loop.mp4";
-  const unsigned loopCount = mView->getLoopCount();
-  sequenceEntry.second.mFilePath = wLoopFilePath;
+  VTime wStartTime(0);
+  switch (mSettings.mBatchTemplate)
+  {
+    case Settings::BatchTemplate::Head:
+      break;
+    case Settings::BatchTemplate::Tail:
+      wStartTime = duration - wLength;
+      break;
+    case Settings::BatchTemplate::Middle:
+      wStartTime = VTime((duration.ms() - wLength.ms()) / 2);
+      break;
+  }
+  const Sequence wSequence{ wStartTime, wStartTime + wLength };
+
+  const QString wVideoPath = videoUrl.toLocalFile();
+  const QString wCutFilePath = cutFilePath(wVideoPath, wSequence, QString(".batch%1.mp4").arg(index, 3, 10, QChar('0')));
+
+  Job wJob;
+  wJob.mProgram = mFFMpegPath;
+  wJob.mSourcePath = wVideoPath;
+  wJob.mDestinationPath = wCutFilePath;
+  wJob.mDuration = wLength;
+  wJob.mBulk = true;
+  wJob.mInputBytes = rangeBytes(wVideoPath, duration, wSequence);
+  wJob.mOutputBytes = wJob.mInputBytes;
+  if (precise)
+  {
+    const FilterChain wFilterChain = filterChain();
+    wJob.mName = "Batch precise cut of " + QFileInfo(wVideoPath).fileName();
+    wJob.mArguments = { "-hide_banner", "-loglevel", "info", "-y" };
+    if (mGpuEncode)
+    {
+      wJob.mArguments.append({ "-hwaccel", "cuda" });
+    }
+    wJob.mArguments.append(inputArguments(wVideoPath, wSequence.first, wSequence.second));
+    wJob.mArguments.append(wFilterChain.arguments());
+    wJob.mArguments.append({ "-c:v", mGpuEncode ? "h264_nvenc" : "libx264" });
+    wJob.mArguments.append(threadArguments());
+    wJob.mArguments.append({ "-c:a", "aac", wCutFilePath });
+    wJob.mTimeScale = wFilterChain.speed();
+  }
+  else
+  {
+    wJob.mName = "Batch fast cut of " + QFileInfo(wVideoPath).fileName();
+    wJob.mArguments = fastCutArguments(wVideoPath, wSequence, wCutFilePath);
+  }
 
-  // TODO: ugly nested process definitions down there. As these are dependent, we need to wait for the first one to finish before starting the second one
-  // so the whole dependency scheduling is done in the previous process onfinished callback... in theory this is ok, but must have better implementation
-  const QString wCutFilePath = QFileInfo(wLoopFilePath).absolutePath() + QFileInfo(wLoopFilePath).completeBaseName() + "_cut.mp4";
+  // not bound to a sequence of the current video, only the log tells about them
+  JobHandlers wHandlers;
+  wHandlers.mFinished = [this, wName = wJob.mName](bool succeeded) {
+    logStatusMessage(wName + (succeeded ? " succeeded" : " failed"));
+  };
+  runJob(wJob, std::move(wHandlers));
+}
 
-  mProcesses.push_back(std::make_unique<QProcess>(this));
-  QProcess* wCutProcess = mProcesses.back().get();
-  connect(wCutProcess, &QProcess::started, this, [&]() {
-    sequenceEntry.second.mState = OperationState::Processing;
-    sequenceEntry.second.mProcessTimer = VTime(0);
-    mView->setSequences(mSequenceMap);
-    logStatusMessage(QString("Loop cut started on ") + (mGpuEncode ? "GPU" : "CPU") + (mDeinterlace ? " with deinterlacing" : ""));
-    });
+void MediaPlayer::exportSequences()
+{
+  if (mSequenceMap.empty() || mPreviewing || mGridSize > 0)
+  {
+    return;
+  }
 
-  connect(wCutProcess, &QProcess::finished, this, [&, wCutFilePath, wLoopFilePath, loopCount](int exitCode, QProcess::ExitStatus exitStatus) {
-    logStatusMessage(QString("Precise cut ") + (exitCode == 0 ? "succeeded" : "failed"));
-    if (exitCode != 0)
+  // the selected sequence, or all of them
+  const QUrl wFileUrl = Playlist::fileUrl(mPlaylist.current());
+  QStringList wLines;
+  for (const auto& wSequenceEntry : mSequenceMap)
+  {
+    if (mSelectedSequence == nullptr || wSequenceEntry.first == *mSelectedSequence)
     {
-      sequenceEntry.second.mState = OperationState::Failed;
-      mView->setSequences(mSequenceMap);
-      return;
+      wLines.push_back(Playlist::toLine(Playlist::rangeUrl(wFileUrl, wSequenceEntry.first)));
     }
+  }
+  if (wLines.empty())
+  {
+    return;
+  }
 
-    const QString wReversedFilePath = QFileInfo(wCutFilePath).absolutePath() + QFileInfo(wCutFilePath).completeBaseName() + "_reversed.mp4";
+  const QString wPlaylistPath = mOutputRootDirectory + "selection.mpl";
+  QFile wFile(wPlaylistPath);
+  if (!wFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+  {
+    logStatusMessage("Cannot open " + wPlaylistPath);
+    return;
+  }
+  wFile.write((wLines.join('\n') + '\n').toUtf8());
+  logStatusMessage(QString("%1 sequence(s) added to %2").arg(wLines.size()).arg(wPlaylistPath));
+}
 
-    // Execute reverser process
-    mProcesses.push_back(std::make_unique<QProcess>(this));
-    QProcess* wReverserProcess = mProcesses.back().get();
-    connect(wReverserProcess, &QProcess::started, this, [&]() {
-      sequenceEntry.second.mProcessTimer = VTime(0);
-      mView->setSequences(mSequenceMap);
-      logStatusMessage("Reverser started");
-      });
+void MediaPlayer::exportChapters()
+{
+  if (mSequenceMap.empty() || mPreviewing || mGridSize > 0)
+  {
+    return;
+  }
 
-    connect(wReverserProcess, &QProcess::finished, this, [&, wCutFilePath, wLoopFilePath, wReversedFilePath, loopCount](int exitCode, QProcess::ExitStatus exitStatus) {
-      logStatusMessage(QString("Reverser ") + (exitCode == 0 ? "succeeded" : "failed"));
-      if (exitCode != 0)
-      {
-        sequenceEntry.second.mState = OperationState::Failed;
-        mView->setSequences(mSequenceMap);
-        return;
-      }
+  const QString wVideoPath = mPlaylist.current().toLocalFile();
+  const QString wBasePath = mOutputRootDirectory + utils::prettifyFileName(QFileInfo(wVideoPath).completeBaseName()) + ".chapters";
+  const QString wMetadataPath = wBasePath + ".txt";
 
-      // Merge the files
-      // Create concat list file
-      const QString wConcatFilePath = utils::uniqueFileName(mOutputRootDirectory + "concat.txt");
-      {
-        std::ofstream ofs(wConcatFilePath.toStdString());
-        for (unsigned n = 0; n < loopCount; ++n)
-        {
-          ofs << "file " << (wCutFilePath.toStdString()) << "\n";
-          ofs << "file " << (wReversedFilePath.toStdString()) << "\n";
-        }
-      }
+  // the chapter file is kept next to the copy, players and editors can import it on its own
+  QStringList wLines = { ";FFMETADATA1" };
+  int wIndex = 0;
+  for (const auto& wSequenceEntry : mSequenceMap)
+  {
+    const Sequence& wSequence = wSequenceEntry.first;
+    wLines.append({ "[CHAPTER]",
+                    "TIMEBASE=1/1000",
+                    QString("START=%1").arg(wSequence.first.ms()),
+                    QString("END=%1").arg(wSequence.second.ms()),
+                    "title=" + escapeMetadata(QString("Sequence %1 (%2 - %3)").arg(++wIndex).arg(wSequence.first.toString(), wSequence.second.toString())) });
+  }
 
-      // Execute merger process
-      mProcesses.push_back(std::make_unique<QProcess>(this));
-      QProcess* wMergerProcess = mProcesses.back().get();
-      connect(wMergerProcess, &QProcess::started, this, [&]() {
-        sequenceEntry.second.mProcessTimer = VTime(0);
-        mView->setSequences(mSequenceMap);
-        logStatusMessage("Merger started");
-        });
+  QFile wFile(wMetadataPath);
+  if (!wFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    logStatusMessage("Cannot open " + wMetadataPath);
+    return;
+  }
+  wFile.write((wLines.join('\n') + '\n').toUtf8());
+  wFile.close();
+  logStatusMessage(QString("%1 chapter(s) written to %2").arg(wIndex).arg(wMetadataPath));
 
-      connect(wMergerProcess, &QProcess::finished, this, [&, wConcatFilePath, wCutFilePath, wReversedFilePath](int exitCode, QProcess::ExitStatus exitStatus) {
-        sequenceEntry.second.mState = exitCode == 0 ? OperationState::Succeeded : OperationState::Failed;
-        mView->setSequences(mSequenceMap);
-        logStatusMessage(QString("Loop cut ") + (exitCode == 0 ? "succeeded" : "failed"));
-
-        QFile::remove(wConcatFilePath);
-        QFile::remove(wCutFilePath);
-        QFile::remove(wReversedFilePath);
-        });
-
-      connect(wMergerProcess, &QProcess::readyReadStandardOutput, this, [&, this, wMergerProcess]() {
-        QString output = QString::fromLocal8Bit(wMergerProcess->readAllStandardOutput());
-        if (!output.isEmpty())
-        {
-          QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-          QRegularExpressionMatchIterator i = re.globalMatch(output);
-          while (i.hasNext()) {
-            QRegularExpressionMatch match = i.next();
-            if (match.hasMatch()) {
-              const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-              const VTime time = VTime(timeStr);
-              const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-              if (time < duration)
-              {
-                sequenceEntry.second.mProcessTimer = time;
-              }              
-              else
-              {
-                sequenceEntry.second.mProcessTimer = duration;
-              }
-              mView->setSequences(mSequenceMap);
-            }
-          }
-        }
-        });
-      connect(wMergerProcess, &QProcess::readyReadStandardError, this, [&, this, wMergerProcess]() {
-        QString error = QString::fromLocal8Bit(wMergerProcess->readAllStandardError());
-        if (!error.isEmpty())
-        {
-          QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-          QRegularExpressionMatchIterator i = re.globalMatch(error);
-          while (i.hasNext()) {
-            QRegularExpressionMatch match = i.next();
-            if (match.hasMatch()) {
-              const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-              const VTime time = VTime(timeStr);
-              const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-              if (time < duration)
-              {
-                sequenceEntry.second.mProcessTimer = time;
-              }
-              else
-              {
-                sequenceEntry.second.mProcessTimer = duration;
-              }
-              mView->setSequences(mSequenceMap);
-            }
-          }
-        }
-        });
-
-      QStringList wArguments;
-      wArguments << "-f" << "concat" << "-safe" << "0" << "-i" << wConcatFilePath << "-c" << "copy" << wLoopFilePath << "-y";
-      wMergerProcess->start(mFFMpegPath, wArguments);
-      });
-
-    connect(wReverserProcess, &QProcess::readyReadStandardOutput, this, [&, this, wReverserProcess]() {
-      QString output = QString::fromLocal8Bit(wReverserProcess->readAllStandardOutput());
-      if (!output.isEmpty())
-      {
-        QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-        QRegularExpressionMatchIterator i = re.globalMatch(output);
-        while (i.hasNext()) {
-          QRegularExpressionMatch match = i.next();
-          if (match.hasMatch()) {
-            const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-            const VTime time = VTime(timeStr);
-            const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-            if (time < duration)
-            {
-              sequenceEntry.second.mProcessTimer = time;
-            }
-            else
-            {
-              sequenceEntry.second.mProcessTimer = duration;
-            }
-            mView->setSequences(mSequenceMap);
-          }
-        }
-      }
-      });
+  if (!mSettings.mChapterRemux)
+  {
+    return;
+  }
 
-    connect(wReverserProcess, &QProcess::readyReadStandardError, this, [&, this, wReverserProcess]() {
-      QString error = QString::fromLocal8Bit(wReverserProcess->readAllStandardError());
-      if (!error.isEmpty())
-      {
-        QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-        QRegularExpressionMatchIterator i = re.globalMatch(error);
-        while (i.hasNext()) {
-          QRegularExpressionMatch match = i.next();
-          if (match.hasMatch()) {
-            const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-            const VTime time = VTime(timeStr);
-            const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-            if (time < duration)
-            {
-              sequenceEntry.second.mProcessTimer = time;
-            }
-            else
-            {
-              sequenceEntry.second.mProcessTimer = duration;
-            }
-            mView->setSequences(mSequenceMap);
-          }
-        }
-      }
-      });
+  // no encoding, the streams are copied as they are, matroska takes chapters next to any codec the source may have
+  const QString wOutputPath = wBasePath + ".mkv";
+  Job wJob;
+  wJob.mName = "Chapter export of " + QFileInfo(wVideoPath).fileName();
+  wJob.mProgram = mFFMpegPath;
+  wJob.mArguments = { "-hide_banner", "-loglevel", "info", "-y",
+                      "-i", wVideoPath,
+                      "-i", wMetadataPath,
+                      "-map", "0:v", "-map", "0:a?",
+                      "-map_metadata", "0", // the title, the creation time and so on stay, only the chapters come from the file
+                      "-map_chapters", "1",
+                      "-c", "copy",
+                      wOutputPath };
+  wJob.mSourcePath = wVideoPath;
+  wJob.mDestinationPath = wOutputPath;
+  wJob.mDuration = mPlayer->getDuration();
+  wJob.mInputBytes = QFileInfo(wVideoPath).size();
+  wJob.mOutputBytes = wJob.mInputBytes;
+
+  JobHandlers wHandlers;
+  wHandlers.mStarted = [this, wName = wJob.mName]() {
+    logStatusMessage(wName + " started");
+  };
+  wHandlers.mFinished = [this, wName = wJob.mName](bool succeeded) {
+    logStatusMessage(wName + (succeeded ? " succeeded" : " failed"));
+  };
+  runJob(wJob, std::move(wHandlers));
+}
 
-    wReverserProcess->start(mFFMpegPath, {
-      "-i", wCutFilePath,
-      "-vf", "reverse",
-      "-af", "areverse",
-      wReversedFilePath, "-y" });
-    });
+void MediaPlayer::speculate(const Sequence& sequence)
+{
+  if (!mSettings.mSpeculativeCut || mPreviewing || mSpeculations.count(sequence) > 0)
+  {
+    return;
+  }
 
-  connect(wCutProcess, &QProcess::readyReadStandardOutput, this, [&, this, wCutProcess]() {
-    QString output = QString::fromLocal8Bit(wCutProcess->readAllStandardOutput());
-    if (!output.isEmpty())
+  const QUrl wVideoUrl = mPlaylist.current();
+  const QString wVideoPath = wVideoUrl.toLocalFile();
+
+  Speculation wSpeculation;
+  wSpeculation.mVideoUrl = wVideoUrl;
+  wSpeculation.mCutFilePath = cutFilePath(wVideoPath, sequence, ".mp4");
+  wSpeculation.mFilePath = cutFilePath(wVideoPath, sequence, QString(".speculative.%1.mp4").arg(QCoreApplication::applicationPid()));
+
+  // a stream copy, it is only disk work and it yields to every real job of the scheduler
+  Job wJob;
+  wJob.mName = "Fast cut";
+  wJob.mProgram = mFFMpegPath;
+  wJob.mArguments = fastCutArguments(wVideoPath, sequence, wSpeculation.mFilePath);
+  wJob.mSourcePath = wVideoPath;
+  wJob.mDestinationPath = wSpeculation.mFilePath;
+  wJob.mDuration = sequence.second - sequence.first;
+  wJob.mSpeculative = true;
+  wJob.mInputBytes = rangeBytes(wVideoPath, mPlayer->getDuration(), sequence);
+  wJob.mOutputBytes = wJob.mInputBytes;
+
+  // the sequence only follows the job once it is promoted, until then nobody sees it
+  const Job::Id wId = runJob(wJob, {});
+  JobHandlers& wHandlers = mJobHandlers[wId];
+  wHandlers.mStarted = [this, sequence, wId]() {
+    Speculation* wSpeculation = speculation(sequence, wId);
+    if (wSpeculation == nullptr)
     {
-      QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-      QRegularExpressionMatchIterator i = re.globalMatch(output);
-      while (i.hasNext()) {
-        QRegularExpressionMatch match = i.next();
-        if (match.hasMatch()) {
-          const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-          const VTime time = VTime(timeStr);
-          const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-          if (time < duration)
-          {
-            sequenceEntry.second.mProcessTimer = time;
-          }
-          else
-          {
-            sequenceEntry.second.mProcessTimer = duration;
-          }
-          mView->setSequences(mSequenceMap);
-        }
-      }
+      return;
     }
-    });
-  connect(wCutProcess, &QProcess::readyReadStandardError, this, [&, this, wCutProcess]() {
-    QString error = QString::fromLocal8Bit(wCutProcess->readAllStandardError());
-    if (!error.isEmpty())
+    wSpeculation->mStarted = true;
+    SequenceState* wState = wSpeculation->mPromoted ? sequenceState(sequence, wSpeculation->mVideoUrl) : nullptr;
+    if (wState != nullptr)
     {
-      QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
-      QRegularExpressionMatchIterator i = re.globalMatch(error);
-      while (i.hasNext()) {
-        QRegularExpressionMatch match = i.next();
-        if (match.hasMatch()) {
-          const QString timeStr = match.captured(1); // "hh:mm:ss.mm"
-          const VTime time = VTime(timeStr);
-          const VTime duration = sequenceEntry.first.second - sequenceEntry.first.first;
-          if (time < duration)
-          {
-            sequenceEntry.second.mProcessTimer = time;
-          }
-          else
-          {
-            sequenceEntry.second.mProcessTimer = duration;
-          }
-          mView->setSequences(mSequenceMap);
-        }
-      }
+      wState->mState = OperationState::Processing;
+      mView->setSequences(mSequenceMap);
     }
-    });
-
-  // Exectute cut process
-  QStringList args;
-  {
-    args = { "-hide_banner", "-loglevel", "info", "-y" };
-    if (mGpuEncode)
+  };
+  wHandlers.mProgress = [this, sequence, wId](const VTime& time) {
+    Speculation* wSpeculation = speculation(sequence, wId);
+    if (wSpeculation == nullptr)
     {
-      args.append({ "-hwaccel", "cuda" });
+      return;
     }
-
-    const VTime wPreloadTime(1000);
-    if (wStartTime >= wPreloadTime)
+    wSpeculation->mProgress = time;
+    SequenceState* wState = wSpeculation->mPromoted ? sequenceState(sequence, wSpeculation->mVideoUrl) : nullptr;
+    if (wState != nullptr)
     {
-      args = {
-          "-ss", (wStartTime - wPreloadTime).toString(),
-          "-i", mPlaylist.current().toLocalFile(),
-          "-ss", wPreloadTime.toString(),
-      };
+      wState->mProcessTimer = time;
+      mView->setSequences(mSequenceMap);
     }
-    else
+  };
+  wHandlers.mFinished = [this, sequence, wId, wFilePath = wSpeculation.mFilePath](bool succeeded) {
+    Speculation* wSpeculation = speculation(sequence, wId);
+    if (wSpeculation == nullptr)
     {
-      args = {
-          "-i", mPlaylist.current().toLocalFile(),
-          "-ss", wStartTime.toString(),
-          "-t", (wEndTime - wStartTime).toString(),
-      };
+      if (mSpeculations.count(sequence) == 0)
+      {
+        QFile::remove(wFilePath); // dropped meanwhile, the partial output is useless
+      }
+      return;
     }
+    if (succeeded && !wSpeculation->mPromoted)
+    {
+      wSpeculation->mFinished = true; // waits for the user
+      return;
+    }
+
+    const bool wPromoted = wSpeculation->mPromoted;
+    const QUrl wVideoUrl = wSpeculation->mVideoUrl;
+    const bool wPublished = succeeded && replaceFile(wSpeculation->mFilePath, wSpeculation->mCutFilePath);
+    QFile::remove(wSpeculation->mFilePath);
+    mSpeculations.erase(sequence);
+    if (wPromoted)
+    {
+      finishSequence(sequence, wVideoUrl, "Fast cut", wPublished);
+    }
+  };
+
+  wSpeculation.mJob = wId;
+  mSpeculations.emplace(sequence, std::move(wSpeculation));
+}
+
+MediaPlayer::Speculation* MediaPlayer::speculation(const Sequence& sequence, const Job::Id id)
+{
+  auto wIt = mSpeculations.find(sequence);
+  return wIt == mSpeculations.end() || wIt->second.mJob != id ? nullptr : &wIt->second;
+}
+
+bool MediaPlayer::promoteSpeculation(SequenceEntry& sequenceEntry)
+{
+  auto wIt = mSpeculations.find(sequenceEntry.first);
+  if (wIt == mSpeculations.end() || wIt->second.mVideoUrl != mPlaylist.current())
+  {
+    return false;
+  }
+
+  Speculation& wSpeculation = wIt->second;
+  sequenceEntry.second.mFilePath = wSpeculation.mCutFilePath;
+  if (wSpeculation.mFinished)
+  {
+    // the output is already there, only its name is missing
+    const bool wSucceeded = replaceFile(wSpeculation.mFilePath, wSpeculation.mCutFilePath);
+    QFile::remove(wSpeculation.mFilePath);
+    const QUrl wVideoUrl = wSpeculation.mVideoUrl;
+    mSpeculations.erase(wIt);
+    finishSequence(sequenceEntry.first, wVideoUrl, "Fast cut", wSucceeded);
+    return true;
+  }
+
+  wSpeculation.mPromoted = true;
+  mScheduler->promote(wSpeculation.mJob);
+  sequenceEntry.second.mState = wSpeculation.mStarted ? OperationState::Processing : OperationState::Queued;
+  sequenceEntry.second.mProcessTimer = wSpeculation.mProgress;
+  mView->setSequences(mSequenceMap);
+  logStatusMessage("Fast cut promoted");
+  return true;
+}
+
+void MediaPlayer::dropSpeculation(const Sequence& sequence)
+{
+  auto wIt = mSpeculations.find(sequence);
+  if (wIt == mSpeculations.end())
+  {
+    return;
+  }
+
+  // erased first, a pending job is finished from within cancel
+  const Speculation wSpeculation = std::move(wIt->second);
+  mSpeculations.erase(wIt);
+  if (wSpeculation.mFinished)
+  {
+    QFile::remove(wSpeculation.mFilePath);
+  }
+  else
+  {
+    mScheduler->cancel(wSpeculation.mJob); // the partial output is removed when the job is gone
+  }
+}
 
-    args.append({ "-t", (wEndTime - wStartTime).toString() });
+void MediaPlayer::dropSpeculations()
+{
+  while (!mSpeculations.empty())
+  {
+    dropSpeculation(mSpeculations.begin()->first);
+  }
+}
 
-    if (mDeinterlace)
+void MediaPlayer::removeSpeculationLeftovers()
+{
+  // an other window may still build on its own speculations, only the ones of gone processes are removed
+  static const QRegularExpression sPattern(R"(\.speculative\.(\d+)\.mp4$)");
+  const QDir wDirectory(mOutputRootDirectory);
+  for (const QString& wFileName : wDirectory.entryList({ "*.speculative.*.mp4" }, QDir::Files))
+  {
+    const QRegularExpressionMatch wMatch = sPattern.match(wFileName);
+    if (wMatch.hasMatch() && !isProcessRunning(wMatch.captured(1).toLongLong()))
     {
-      args.append({ "-vf", "yadif" });
+      QFile::remove(wDirectory.filePath(wFileName));
     }
-    args.append({ "-c:v", mGpuEncode ? "h264_nvenc" : "libx264" }); // GPU or CPU
-    args.append({ "-c:a", "aac", wCutFilePath });
+  }
+}
+
+void MediaPlayer::startPreview(const Sequence& sequence)
+{
+  auto wSequenceEntryIt = mSequenceMap.find(sequence);
+  if (wSequenceEntryIt == mSequenceMap.end() || !QFile::exists(wSequenceEntryIt->second.mFilePath) || mGridSize > 0)
+  {
+    return;
   }
 
-  wCutProcess->start(mFFMpegPath, args);
+  stopLoop();
+  mPreviewReturnPosition = mPlayer->getPosition();
+  mPreviewSequence = sequence;
+  mPreviewing = true;
+  mLoadPosition.reset();
+  mEditedSequence = Sequence{ VTime(0), VTime(0) };
+  mView->setMarking(false);
+
+  stop();
+  mPlayer->setVideo(QUrl::fromLocalFile(wSequenceEntryIt->second.mFilePath));
+  logStatusMessage(QString("Previewing %1").arg(wSequenceEntryIt->second.mFilePath));
+}
+
+void MediaPlayer::stopPreview()
+{
+  if (!mPreviewing)
+  {
+    return;
+  }
+
+  mPreviewing = false;
+  mLoadPosition = mPreviewReturnPosition;
+
+  stop();
+  mPlayer->setVideo(mPlaylist.current());
+  mView->setSequences(mSequenceMap);
+  logStatusMessage("Preview finished");
+}
+
+bool MediaPlayer::isPreviewing() const
+{
+  return mPreviewing;
 }
 
 void MediaPlayer::resetSeqenceState()
@@ -1053,6 +2124,11 @@ void MediaPlayer::deleteSequence()
     }
   }
 
+  if (mLoop == *mSelectedSequence)
+  {
+    stopLoop();
+  }
+  dropSpeculation(*mSelectedSequence);
   mSequenceMap.erase(*mSelectedSequence);
   mView->setSequences(mSequenceMap);
 }
@@ -5,24 +5,37 @@
 #include "Settings.h"
 #include "Playlist.h"
 #include "Filter.h"
+#include "JobQueue.h"
+#include "Utils.h"
 
 #include <QObject>
 #include <QSize>
+#include <QStringList>
+#include <QThreadPool>
 
+#include <functional>
+#include <map>
 #include <memory>
+#include <optional>
 
 class View;
 class VideoPlayer;
 class QLayout;
 class QProcess;
 class QString;
+class QosController;
+class Prefetcher;
+class KeyframeIndex;
+class ReversePlayer;
+class SeekTargets;
+class GridPlayer;
 
 class MediaPlayer : public QObject
 {
   Q_OBJECT
 
 public:
-  enum class CutMethod { Fast, Precise, Loop };
+  enum class CutMethod { Fast, Precise, Loop, Ladder, TimeLapse, Sized, Animation, Frames };
   enum class SeekStep { Normal, Small, Big, Random };
   enum class SeekDirection { Forward, Backward };
   enum class SnapPosition { Start, End };
@@ -51,16 +64,43 @@ public:
   bool isFullscreen() const;
 
   void setPosition(const VTime& position, const bool updateNeeded = false);
+  void scrub(const VTime& position); // the slider, the seek statistics are shown for the user input only
   VTime getPosition() const;
   QSize getVideoDimensions() const;
 
   void seek(SeekDirection direction, SeekStep step);
   void snapToSelection(SnapPosition position);
   void startStop();
+  void reversePlay(); // toggles, backward from the frame on screen at the speed of the playback, see ReversePlayer
+  // toggles the a/b loop of the selected sequence, ping-pong plays it forward and backward like a loop cut would
+  void loopPlay(const bool pingPong);
+  // J/K/L: -1 backward, 1 forward, repeated presses double the speed, 0 pauses, see DecodeStrategy
+  void shuttle(const int direction);
+
+  // multi-view of the current and the upcoming entries: 4, 9, 16 tiles, then back to the player, see GridPlayer
+  // next and previous page through the playlist, a click on a tile plays it
+  void toggleGrid();
 
   void mark(const bool isCancel = false);
   void cut(const CutMethod cutMethod);
 
+  // plays the growing output of an in progress cut, the source is restored with stopPreview
+  void startPreview(const Sequence& sequence);
+  void stopPreview();
+  bool isPreviewing() const;
+
+  // saves the frame on screen as an image, the encoding runs on the image pool
+  void captureFrame();
+
+  // cuts the same template range (see Settings::BatchTemplate) of every video of the playlist
+  void batchCut(const bool precise);
+
+  // appends the sequences of the video to the selection playlist as range entries, they play without being cut
+  void exportSequences();
+
+  // all the sequences of the video as chapters, into an ffmetadata file and a stream copy of the video, see Settings::mChapterRemux
+  void exportChapters();
+
   // sequence management
   void resetSeqenceState();
   void deleteSequence();
@@ -78,10 +118,75 @@ private:
   void onVideoLoaded();
   void onVideoEnded();
   void onFilterTextChanged(const QString& text);
+  VTime entryStart() const; // where the current playlist entry starts, see Playlist::range
+  void loadKeyframes();     // for the current file, the seeks show keyframes while scrubbing, see VideoPlayer::requestSeek
+  void stopReverse();
+  void stopLoop();
+  void prepareSeekTargets(); // the next random seeks from the position, see Settings::mPredecodeSeeks
+  void showReverseHealth();
+  void showGrid();
+  void closeGrid();
+  void promoteTile(const std::size_t index);
+  void preloadReverseLoop(); // the backward pass of a ping-pong loop is decoded while the forward one plays
+  double frameRate() const;
+  void prepareNext();       // pre-warms the entry next() goes to and prefetches the ones after, see Settings::mPrewarmNext
 
   void FastCut(SequenceEntry& sequenceEntry);
-  void PreciseCut(SequenceEntry& sequenceEntry);
+  void PreciseCut(SequenceEntry& sequenceEntry, const QStringList& rateArguments = {});
   void LoopCut(SequenceEntry& sequenceEntry);
+  void LadderCut(SequenceEntry& sequenceEntry);
+  void TimeLapseCut(SequenceEntry& sequenceEntry);
+  void SizedCut(SequenceEntry& sequenceEntry); // precise cut with the quality predicted for the target size
+  void AnimationCut(SequenceEntry& sequenceEntry); // animated webp or gif straight from the source
+  void FramesCut(SequenceEntry& sequenceEntry); // every Nth frame as an image, into a directory named after the cut
+
+  FilterChain filterChain() const; // the encode filters enabled by the user
+  QStringList inputArguments(const QString& videoPath, const VTime& startTime, const VTime& endTime) const;
+  QStringList fragmentArguments() const;
+  QString cutFilePath(const QString& videoPath, const Sequence& sequence, const QString& suffix) const;
+  QStringList fastCutArguments(const QString& videoPath, const Sequence& sequence, const QString& outputPath) const;
+  QString encoderDescription() const;
+  QString imageSuffix() const;
+  QStringList threadArguments() const;
+  qint64 rangeBytes(const QString& videoPath, const VTime& videoDuration, const Sequence& sequence) const; // estimated, constant bitrate
+
+  // jobs
+  struct JobHandlers
+  {
+    std::function<void()> mStarted;
+    std::function<void(const VTime&)> mProgress;
+    std::function<void(bool)> mFinished;
+  };
+
+  Job::Id runJob(const Job& job, JobHandlers handlers);
+  // the state of the sequence follows the job, onFinished replaces the final state update, it is for the dependent steps
+  // inputPath is the file the job reads if it is not the video, e.g. an intermediate of the previous step
+  Job::Id submitSequenceJob(const Sequence& sequence, const QUrl& videoUrl, const QString& name, const QStringList& arguments
+                            , const QString& outputPath, const double timeScale = 1.0, std::function<void(bool)> onFinished = {}
+                            , const QString& inputPath = QString());
+  SequenceState* sequenceState(const Sequence& sequence, const QUrl& videoUrl); // nullptr if the sequence is not shown anymore
+  void finishSequence(const Sequence& sequence, const QUrl& videoUrl, const QString& name, const bool succeeded);
+  void submitBatchJob(const QUrl& videoUrl, const int index, const VTime& duration, const bool precise);
+
+  // speculative fast cuts of the freshly marked sequences, see Settings::mSpeculativeCut
+  struct Speculation
+  {
+    Job::Id mJob = 0;
+    QUrl mVideoUrl;
+    QString mFilePath;    // next to the real output, tagged with the process id, renamed to the output when the cut is asked for
+    QString mCutFilePath;
+    bool mPromoted = false; // the user asked for it, the sequence follows the job
+    bool mStarted = false;
+    bool mFinished = false; // succeeded, waiting for the user
+    VTime mProgress;
+  };
+
+  void speculate(const Sequence& sequence);
+  bool promoteSpeculation(SequenceEntry& sequenceEntry); // false if there is no speculation to build on
+  void dropSpeculation(const Sequence& sequence);
+  void dropSpeculations();
+  void removeSpeculationLeftovers(); // of the players not running anymore, e.g. after a crash
+  Speculation* speculation(const Sequence& sequence, const Job::Id id); // nullptr if it was dropped or replaced since
 
 private:
   // controller data
@@ -99,12 +204,38 @@ private:
   Sequence mEditedSequence = Sequence{ VTime(0), VTime(0) };
   Sequence const* mSelectedSequence = nullptr;
 
-  using ProcessPtr = std::unique_ptr<QProcess>;
-  std::vector<ProcessPtr> mProcesses; // TODO: destroy finished processsed, do not accumulate them
+  // preview of in progress outputs
+  bool mPreviewing = false;
+  Sequence mPreviewSequence;
+  VTime mPreviewReturnPosition;
+  std::optional<VTime> mLoadPosition; // position to seek to when the next video is loaded, instead of the start
 
-  const QString mFFMpegPath = "d:\\Tools\\ffmpeg\\ffmpeg.exe"; // TODO: settings
+  // a/b loop of a sequence
+  std::optional<Sequence> mLoop;
+  bool mPingPong = false;
+
+  std::size_t mShuttleStep = 0; // index of the shuttle rate
+
+  std::size_t mGridSize = 0; // tiles of the multi-view, 0 while the player is shown, the player controls are ignored then
+  QUrl mGridReturnUrl;       // loaded in the player behind the grid
+
+  // encoder jobs
+  std::unique_ptr<JobQueue> mScheduler; // the job daemon, or this process if it can not be reached
+  std::map<Job::Id, JobHandlers> mJobHandlers;
+  std::unique_ptr<QosController> mQos; // throttles the jobs while the playback needs the machine
+  std::map<Sequence, Speculation> mSpeculations;
+
+  const QString mFFMpegPath = utils::ffmpegPath();
   const QString mOutputRootDirectory = "a:\\";  // TODO: settings
 
   // settings
   Settings mSettings;
+
+  std::unique_ptr<Prefetcher> mPrefetcher; // page cache warm-up of the upcoming entries
+  std::unique_ptr<KeyframeIndex> mKeyframes; // of the current file, once the user seeks in it
+  std::unique_ptr<ReversePlayer> mReversePlayer;
+  std::unique_ptr<SeekTargets> mSeekTargets; // the frames of the next random seeks
+  std::unique_ptr<GridPlayer> mGridPlayer;
+
+  QThreadPool mImagePool; // still frame encoding, last member so it is drained before the rest is destroyed
 };
@@ -2,8 +2,10 @@
 #include "Utils.h"
 
 #include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <random>
+#include <QDir>
 #include <QFileInfo>
 #include <QRegularExpression>
 
@@ -127,6 +129,32 @@ QUrl Playlist::current() const
   return mUrls[currentIndex()];
 }
 
+QUrl Playlist::upcoming() const
+{
+  if (mUrls.empty() || mCurrentIndex == npos || mIndices.size() <= 1)
+  {
+    return QUrl();
+  }
+  return mUrls[mIndices[(mCurrentIndex + 1) % mIndices.size()]];
+}
+
+std::vector<QUrl> Playlist::upcoming(const std::size_t count) const
+{
+  std::vector<QUrl> result;
+  if (mUrls.empty() || mCurrentIndex == npos || mIndices.size() <= 1)
+  {
+    return result;
+  }
+
+  const std::size_t wCount = std::min(count, mIndices.size() - 1);
+  result.reserve(wCount);
+  for (std::size_t i = 1; i <= wCount; ++i)
+  {
+    result.push_back(mUrls[mIndices[(mCurrentIndex + i) % mIndices.size()]]);
+  }
+  return result;
+}
+
 bool Playlist::next()
 {
   if (mUrls.empty() || mIndices.size() <= 1 || mIndices.empty())
@@ -264,3 +292,65 @@ void Playlist::setFilter(const QString& pattern)
 
   mCurrentIndex = mIndices.empty() ? npos : 0;
 }
+
+QUrl Playlist::rangeUrl(const QUrl& fileUrl, const Sequence& range)
+{
+  QUrl wUrl = Playlist::fileUrl(fileUrl);
+  wUrl.setFragment(QString("t=%1,%2").arg(range.first.ms() / 1000.0, 0, 'f', 3).arg(range.second.ms() / 1000.0, 0, 'f', 3));
+  return wUrl;
+}
+
+std::optional<Sequence> Playlist::range(const QUrl& url)
+{
+  static const QRegularExpression re(R"(^t=(\d+(?:\.\d+)?),(\d+(?:\.\d+)?)$)");
+  const QRegularExpressionMatch wMatch = re.match(url.fragment());
+  if (!wMatch.hasMatch())
+  {
+    return std::nullopt;
+  }
+
+  const Sequence wRange{ VTime(std::llround(wMatch.captured(1).toDouble() * 1000.0)), VTime(std::llround(wMatch.captured(2).toDouble() * 1000.0)) };
+  if (wRange.second <= wRange.first)
+  {
+    return std::nullopt;
+  }
+  return wRange;
+}
+
+QUrl Playlist::fileUrl(const QUrl& url)
+{
+  return url.adjusted(QUrl::RemoveFragment);
+}
+
+QUrl Playlist::fromLine(const QString& line)
+{
+  // "path" or path, optionally followed by |start|end, the pipe is not allowed in windows paths
+  QStringList wParts = line.trimmed().split('|');
+  QString wPath = wParts.front().trimmed();
+  if (wPath.size() >= 2 && wPath.front() == '"' && wPath.back() == '"')
+  {
+    wPath = wPath.mid(1, wPath.size() - 2);
+  }
+  if (wPath.isEmpty())
+  {
+    return QUrl();
+  }
+
+  const QUrl wUrl = QUrl::fromLocalFile(wPath);
+  if (wParts.size() == 3)
+  {
+    const Sequence wRange{ VTime(wParts[1].trimmed()), VTime(wParts[2].trimmed()) };
+    if (wRange.first < wRange.second)
+    {
+      return rangeUrl(wUrl, wRange);
+    }
+  }
+  return wUrl;
+}
+
+QString Playlist::toLine(const QUrl& url)
+{
+  const QString wPath = "\"" + QDir::toNativeSeparators(url.toLocalFile()) + "\"";
+  const std::optional<Sequence> wRange = range(url);
+  return wRange ? wPath + "|" + wRange->first.toString() + "|" + wRange->second.toString() : wPath;
+}
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "Types.h"
+
 #include <QUrl>
 #include <QString>
 #include <QHash>
+#include <optional>
 #include <vector>
 
+// an entry is a video file, or a range of it: the file url with a "t=start,end" media fragment (seconds)
+// the range entries are played from start to end without being cut, the .mpl line is "path|hh:mm:ss.mmm|hh:mm:ss.mmm"
 class Playlist
 {
   constexpr static size_t npos = -1;
@@ -13,6 +18,12 @@ public:
   Playlist() = default;
   explicit Playlist(std::vector<QUrl>&& urls);
 
+  static QUrl rangeUrl(const QUrl& fileUrl, const Sequence& range);
+  static std::optional<Sequence> range(const QUrl& url); // empty for whole file entries
+  static QUrl fileUrl(const QUrl& url);                   // the url without the range
+  static QUrl fromLine(const QString& line);              // empty for blank lines
+  static QString toLine(const QUrl& url);
+
   std::size_t size() const;
   bool empty() const;
   void clear();
@@ -25,6 +36,8 @@ public:
   std::size_t indexOf(const QUrl& url) const;
 
   QUrl current() const;
+  QUrl upcoming() const; // what next() would move to, in the playback order, empty if nothing
+  std::vector<QUrl> upcoming(const std::size_t count) const; // the entries of the next count next() calls, without the current one
 
   bool next();
   bool previous();
@@ -0,0 +1,149 @@
+#include "Prefetcher.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <utility>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#endif
+
+class Prefetcher::Worker : public QObject
+{
+public:
+  Worker(const std::atomic<quint64>& generation)
+    : mGeneration(generation)
+  {}
+
+  void run(const quint64 generation, const std::vector<QUrl>& videos, const qint64 headBytes, const qint64 budgetBytes)
+  {
+    qint64 wBudget = budgetBytes;
+    for (const QUrl& wVideo : videos)
+    {
+      if (wBudget <= 0 || cancelled(generation))
+      {
+        return;
+      }
+
+      QFile wFile(wVideo.toLocalFile());
+      if (!wFile.open(QIODevice::ReadOnly))
+      {
+        continue;
+      }
+
+      // the index first, without it the player can not even start, the head only gives the first gops
+      const std::pair<qint64, qint64> wIndex = indexRegion(wFile);
+      wBudget -= read(wFile, wIndex.first, std::min(wIndex.second, wBudget), generation);
+      wBudget -= read(wFile, 0, std::min(headBytes, wBudget), generation);
+    }
+  }
+
+private:
+  bool cancelled(const quint64 generation) const
+  {
+    return generation != mGeneration.load(std::memory_order_relaxed);
+  }
+
+  // returns the bytes read, the reads stop at a cancel
+  qint64 read(QFile& file, const qint64 offset, const qint64 size, const quint64 generation)
+  {
+    if (size <= 0 || !file.seek(offset))
+    {
+      return 0;
+    }
+
+    qint64 wRead = 0;
+    while (wRead < size && !cancelled(generation))
+    {
+      const qint64 wChunk = file.read(mBuffer.data(), std::min<qint64>(mBuffer.size(), size - wRead));
+      if (wChunk <= 0)
+      {
+        break;
+      }
+      wRead += wChunk;
+    }
+    return wRead;
+  }
+
+  // offset and size of the moov box of an mp4/mov, walking the top level boxes, or the tail of other containers
+  std::pair<qint64, qint64> indexRegion(QFile& file) const
+  {
+    const qint64 wFileSize = file.size();
+    qint64 wOffset = 0;
+    while (wOffset + 8 <= wFileSize && file.seek(wOffset))
+    {
+      uchar wHeader[16];
+      if (file.read(reinterpret_cast<char*>(wHeader), 8) != 8)
+      {
+        break;
+      }
+
+      qint64 wSize = qFromBigEndian<quint32>(wHeader);
+      const QByteArray wType(reinterpret_cast<const char*>(wHeader + 4), 4);
+      if (wSize == 1 && file.read(reinterpret_cast<char*>(wHeader + 8), 8) == 8)
+      {
+        wSize = static_cast<qint64>(qFromBigEndian<quint64>(wHeader + 8)); // 64 bit size
+      }
+      else if (wSize == 0)
+      {
+        wSize = wFileSize - wOffset; // up to the end
+      }
+
+      if (wType == "moov")
+      {
+        return { wOffset, wSize };
+      }
+      if (wSize < 8 || (wOffset == 0 && wType != "ftyp"))
+      {
+        break; // not an iso media file
+      }
+      wOffset += wSize;
+    }
+
+    // matroska cues, avi idx1 and the moov of a broken mp4 are usually at the end
+    const qint64 wTail = std::min(wFileSize, sTailBytes);
+    return { wFileSize - wTail, wTail };
+  }
+
+  const std::atomic<quint64>& mGeneration;
+  std::vector<char> mBuffer = std::vector<char>(1024 * 1024);
+
+  static constexpr qint64 sTailBytes = 1024 * 1024;
+};
+
+Prefetcher::Prefetcher()
+  : mWorker(new Worker(mGeneration))
+{
+  mThread.setObjectName("Prefetcher");
+  mWorker->moveToThread(&mThread);
+  mThread.start(QThread::LowestPriority);
+
+#ifdef Q_OS_WIN
+  // background mode lowers the i/o priority too, the reads of the player go first
+  QMetaObject::invokeMethod(mWorker, []() { SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN); }, Qt::QueuedConnection);
+#endif
+}
+
+Prefetcher::~Prefetcher()
+{
+  cancel();
+  mThread.quit();
+  mThread.wait();
+  delete mWorker;
+}
+
+void Prefetcher::prefetch(const std::vector<QUrl>& videos, const qint64 headBytes, const qint64 budgetBytes)
+{
+  const quint64 wGeneration = ++mGeneration; // the previous run stops at its next chunk
+  Worker* wWorker = mWorker;
+  QMetaObject::invokeMethod(wWorker, [wWorker, wGeneration, videos, headBytes, budgetBytes]() {
+    wWorker->run(wGeneration, videos, headBytes, budgetBytes);
+    }, Qt::QueuedConnection);
+}
+
+void Prefetcher::cancel()
+{
+  ++mGeneration;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QThread>
+#include <QUrl>
+
+#include <atomic>
+#include <vector>
+
+// warms the page cache for the upcoming playlist entries, the next load finds the container header and the first gops in memory
+// every file gets its head and its index (the moov box of mp4/mov, the tail of the others), read on a background i/o thread
+// the data is thrown away, only the cache of the os keeps it, the budget caps the bytes read for one prefetch call
+class Prefetcher
+{
+public:
+  Prefetcher();
+  ~Prefetcher();
+
+  // replaces the previous prefetch, the files are read in the given order until the budget runs out
+  void prefetch(const std::vector<QUrl>& videos, const qint64 headBytes, const qint64 budgetBytes);
+  void cancel();
+
+private:
+  class Worker;
+
+  QThread mThread;
+  Worker* mWorker = nullptr; // lives on mThread
+  std::atomic<quint64> mGeneration{ 0 }; // a read in progress stops when this moves on
+};
@@ -0,0 +1,209 @@
+#include "ProcessIo.h"
+#include "SpscQueue.h"
+
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTimer>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#endif
+
+class ProcessIo::Worker : public QObject
+{
+public:
+  ~Worker()
+  {
+    killAll();
+  }
+
+  void start(const Job::Id id, const Job& job, const QStringList& arguments, const bool idlePriority)
+  {
+    Process& wEntry = mProcesses[id];
+    wEntry.mDuration = job.mDuration;
+    wEntry.mTimeScale = job.mTimeScale;
+    wEntry.mProcess = std::make_unique<QProcess>();
+    QProcess* wProcess = wEntry.mProcess.get();
+    wProcess->setProcessChannelMode(QProcess::MergedChannels); // ffmpeg reports on stderr, one pipe to read
+
+#ifdef Q_OS_WIN
+    // the priority class is inherited by the encoder threads, set it before the first one runs
+    const DWORD wPriorityClass = idlePriority ? IDLE_PRIORITY_CLASS : BELOW_NORMAL_PRIORITY_CLASS;
+    wProcess->setCreateProcessArgumentsModifier([wPriorityClass](QProcess::CreateProcessArguments* arguments) {
+      arguments->flags |= wPriorityClass;
+      });
+#else
+    Q_UNUSED(idlePriority);
+#endif
+
+    connect(wProcess, &QProcess::started, this, [this, id, wProcess]() {
+      post({ id, ProcessEvent::Type::Started, VTime(), wProcess->processId() });
+      });
+    connect(wProcess, &QProcess::readyReadStandardOutput, this, [this, id]() { onOutput(id); });
+    connect(wProcess, &QProcess::finished, this, [this, id](int exitCode, QProcess::ExitStatus exitStatus) {
+      onFinished(id, exitCode == 0 && exitStatus == QProcess::NormalExit);
+      });
+    connect(wProcess, &QProcess::errorOccurred, this, [this, id](QProcess::ProcessError error) {
+      if (error == QProcess::FailedToStart)
+      {
+        onFinished(id, false); // finished is not emitted for processes never started
+      }
+      });
+    wProcess->start(job.mProgram, arguments);
+  }
+
+  void kill(const Job::Id id)
+  {
+    auto wIt = mProcesses.find(id);
+    if (wIt != mProcesses.end())
+    {
+      wIt->second.mProcess->kill(); // finished is emitted from the process
+    }
+  }
+
+  void killAll()
+  {
+    for (auto& wEntry : mProcesses)
+    {
+      wEntry.second.mProcess->disconnect(this);
+      wEntry.second.mProcess->kill();
+      wEntry.second.mProcess->waitForFinished(1000);
+    }
+    mProcesses.clear();
+  }
+
+  SpscQueue<ProcessEvent, 1024> mEvents;
+
+private:
+  struct Process
+  {
+    std::unique_ptr<QProcess> mProcess;
+    VTime mDuration;
+    double mTimeScale = 1.0;
+    QByteArray mPartialLine; // ffmpeg ends its status lines with \r, the pipe splits them anywhere
+  };
+
+  void onOutput(const Job::Id id)
+  {
+    auto wIt = mProcesses.find(id);
+    if (wIt == mProcesses.end())
+    {
+      return;
+    }
+
+    Process& wEntry = wIt->second;
+    QByteArray wOutput = wEntry.mPartialLine + wEntry.mProcess->readAllStandardOutput();
+    const qsizetype wEnd = std::max(wOutput.lastIndexOf('\r'), wOutput.lastIndexOf('\n')) + 1;
+    wEntry.mPartialLine = wOutput.mid(wEnd);
+    wOutput.truncate(wEnd);
+    if (wOutput.isEmpty())
+    {
+      return;
+    }
+
+    // only the last status line of what arrived matters, the owner could not show the others anyway
+    static const QRegularExpression re(R"(time.*?(\d{2}:\d{2}:\d{2}\.\d{2}))");
+    QRegularExpressionMatch wLast;
+    QRegularExpressionMatchIterator i = re.globalMatch(QString::fromLocal8Bit(wOutput));
+    while (i.hasNext())
+    {
+      wLast = i.next();
+    }
+    if (wLast.hasMatch())
+    {
+      const VTime wTime = VTime(wLast.captured(1)) * wEntry.mTimeScale; // "hh:mm:ss.mm" of the output, scaled back to source time
+      post({ id, ProcessEvent::Type::Progress, wTime < wEntry.mDuration ? wTime : wEntry.mDuration });
+    }
+  }
+
+  void onFinished(const Job::Id id, const bool succeeded)
+  {
+    auto wIt = mProcesses.find(id);
+    if (wIt == mProcesses.end())
+    {
+      return;
+    }
+
+    // we are in a signal of the process, it can not be deleted right now
+    QProcess* wProcess = wIt->second.mProcess.release();
+    wProcess->disconnect(this);
+    wProcess->deleteLater();
+    mProcesses.erase(wIt);
+
+    post({ id, ProcessEvent::Type::Finished, VTime(), 0, succeeded });
+  }
+
+  void post(ProcessEvent&& event)
+  {
+    if (!mEvents.pushOrKeep(std::move(event)))
+    {
+      scheduleFlush(); // the owner is behind
+    }
+  }
+
+  void scheduleFlush()
+  {
+    if (mFlushPending)
+    {
+      return;
+    }
+    mFlushPending = true;
+    QTimer::singleShot(sFlushIntervalMs, this, [this]() {
+      mFlushPending = false;
+      if (!mEvents.flush())
+      {
+        scheduleFlush();
+      }
+      });
+  }
+
+  std::map<Job::Id, Process> mProcesses;
+  bool mFlushPending = false;
+
+  static constexpr int sFlushIntervalMs = 16;
+};
+
+ProcessIo::ProcessIo()
+  : mWorker(new Worker)
+{
+  mThread.setObjectName("ProcessIo");
+  mWorker->moveToThread(&mThread);
+  mThread.start();
+}
+
+ProcessIo::~ProcessIo()
+{
+  killAll();
+  mThread.quit();
+  mThread.wait();
+  delete mWorker;
+}
+
+void ProcessIo::start(const Job::Id id, const Job& job, const QStringList& arguments, const bool idlePriority)
+{
+  Worker* wWorker = mWorker;
+  QMetaObject::invokeMethod(wWorker, [wWorker, id, job, arguments, idlePriority]() {
+    wWorker->start(id, job, arguments, idlePriority);
+    }, Qt::QueuedConnection);
+}
+
+void ProcessIo::kill(const Job::Id id)
+{
+  Worker* wWorker = mWorker;
+  QMetaObject::invokeMethod(wWorker, [wWorker, id]() { wWorker->kill(id); }, Qt::QueuedConnection);
+}
+
+void ProcessIo::killAll()
+{
+  Worker* wWorker = mWorker;
+  QMetaObject::invokeMethod(wWorker, [wWorker]() { wWorker->killAll(); }, Qt::BlockingQueuedConnection);
+}
+
+bool ProcessIo::poll(ProcessEvent& event)
+{
+  return mWorker->mEvents.pop(event);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "JobQueue.h"
+
+#include <QThread>
+
+// what happened to a process of ProcessIo, in the order it happened
+struct ProcessEvent
+{
+  enum class Type { Started, Progress, Finished };
+
+  Job::Id mId = 0;
+  Type mType = Type::Progress;
+  VTime mTime;              // Progress: processed source time, capped to the duration of the job
+  qint64 mProcessId = 0;    // Started
+  bool mSucceeded = false;  // Finished
+};
+
+// runs the encoder processes on a dedicated i/o thread, their pipes are read, decoded and parsed there
+// the owner thread gets compact records through a lock-free queue and never touches the output text
+// start and kill return right away, the owner polls the events, e.g. once per frame
+class ProcessIo
+{
+public:
+  ProcessIo();
+  ~ProcessIo(); // kills the processes still running
+
+  void start(const Job::Id id, const Job& job, const QStringList& arguments, const bool idlePriority);
+  void kill(const Job::Id id);
+  void killAll(); // returns when the processes are gone, there are no events about them
+
+  bool poll(ProcessEvent& event); // owner thread only
+
+private:
+  class Worker;
+
+  QThread mThread;
+  Worker* mWorker = nullptr; // lives on mThread
+};
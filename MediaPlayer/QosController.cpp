@@ -0,0 +1,111 @@
+#include "QosController.h"
+#include "JobQueue.h"
+
+#include <algorithm>
+#include <limits>
+
+QosController::QosController(JobQueue* scheduler, QObject* parent)
+  : QObject(parent)
+  , mScheduler(scheduler)
+{
+  mRestoreTimer.setSingleShot(true);
+  mRestoreTimer.setInterval(sRestoreDelayMs);
+  connect(&mRestoreTimer, &QTimer::timeout, this, [this]() {
+    if (!mPlaying)
+    {
+      restore();
+    }
+  });
+}
+
+void QosController::setPlaying(const bool playing)
+{
+  mPlaying = playing;
+  mHealthyWindows = 0;
+  if (mPlaying)
+  {
+    mRestoreTimer.stop();
+    mBackground = true; // the encoders wait for the idle cpu from the first frame on
+    apply();
+  }
+  else
+  {
+    mRestoreTimer.start(); // a pause between two seeks is not a reason to flood the machine
+  }
+}
+
+void QosController::notifyScrubbing()
+{
+  if (!mBackground)
+  {
+    mBackground = true;
+    apply();
+  }
+  if (!mPlaying)
+  {
+    mRestoreTimer.start();
+  }
+}
+
+void QosController::onPlaybackStatistics(const PlaybackStatistics& statistics)
+{
+  if (!mPlaying)
+  {
+    return;
+  }
+
+  if (statistics.mDroppedFrames > sMaxDroppedFrames || statistics.mMaxLateness.ms() > sMaxLatenessMs)
+  {
+    mHealthyWindows = 0;
+    throttle();
+  }
+  else if (++mHealthyWindows >= sRelaxWindows)
+  {
+    mHealthyWindows = 0;
+    relax();
+  }
+}
+
+void QosController::throttle()
+{
+  // fewer workers first, the bulk jobs go last as the user is waiting for nothing in particular from them
+  const unsigned wCurrent = mLimit == 0 ? mScheduler->maxRunning() : mLimit;
+  if (wCurrent > 1)
+  {
+    mLimit = wCurrent - 1;
+  }
+  else
+  {
+    mBulkPaused = true;
+  }
+  apply();
+}
+
+void QosController::relax()
+{
+  if (mBulkPaused)
+  {
+    mBulkPaused = false;
+  }
+  else if (mLimit != 0)
+  {
+    mLimit = mLimit + 1 >= mScheduler->maxRunning() ? 0 : mLimit + 1;
+  }
+  apply();
+}
+
+void QosController::restore()
+{
+  mLimit = 0;
+  mBulkPaused = false;
+  mBackground = false;
+  mHealthyWindows = 0;
+  apply();
+}
+
+void QosController::apply()
+{
+  mScheduler->setRunningLimit(mLimit == 0 ? std::numeric_limits<unsigned>::max() : mLimit);
+  mScheduler->setBulkPaused(mBulkPaused);
+  mScheduler->setBackground(mBackground);
+}
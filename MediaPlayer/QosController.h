@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Types.h"
+
+#include <QObject>
+#include <QTimer>
+
+class JobQueue;
+
+// trades encoder throughput for smooth playback: while frames are dropped or late the running job limit is
+// lowered step by step, then the bulk jobs are held back; healthy playback, pause or stop gives the slots back
+class QosController : public QObject
+{
+  Q_OBJECT
+
+public:
+  QosController(JobQueue* scheduler, QObject* parent = nullptr);
+
+  void setPlaying(const bool playing);
+  void notifyScrubbing(); // seeks while paused need the decoder as much as the playback does
+  void onPlaybackStatistics(const PlaybackStatistics& statistics);
+
+private:
+  void throttle();
+  void relax();
+  void restore();
+  void apply();
+
+  JobQueue* mScheduler = nullptr;
+  QTimer mRestoreTimer;
+
+  bool mPlaying = false;
+  unsigned mLimit = 0;        // 0 is no limit
+  bool mBulkPaused = false;
+  bool mBackground = false;
+  unsigned mHealthyWindows = 0;
+
+  static constexpr unsigned sMaxDroppedFrames = 1;  // per window
+  static constexpr qint64 sMaxLatenessMs = 40;
+  static constexpr unsigned sRelaxWindows = 5;      // healthy windows before a slot is given back
+  static constexpr int sRestoreDelayMs = 2000;
+};
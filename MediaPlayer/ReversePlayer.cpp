@@ -0,0 +1,319 @@
+#include "ReversePlayer.h"
+#include "VideoPlayer.h"
+#include "KeyframeIndex.h"
+#include "Utils.h"
+
+#include <QProcess>
+
+#include <algorithm>
+#include <cmath>
+
+class ReversePlayer::Worker : public QObject
+{
+public:
+  Worker(ReversePlayer* owner, const std::atomic<quint64>& generation)
+    : mOwner(owner)
+    , mGeneration(generation)
+  {}
+
+  void decode(const quint64 generation, const QString& ffmpegPath, const QString& videoPath, const VTime& start, const VTime& end, const QSize& size, const double fps)
+  {
+    if (cancelled(generation))
+    {
+      return;
+    }
+
+    // the seek before the input decodes from the keyframe and drops what is before start
+    QProcess wProcess;
+    wProcess.setStandardErrorFile(QProcess::nullDevice());
+    wProcess.start(ffmpegPath, { "-hide_banner", "-loglevel", "error",
+                                 "-ss", start.toString(),
+                                 "-i", videoPath,
+                                 "-t", (end - start).toString(),
+                                 "-an", "-sn",
+                                 "-vf", QString("scale=%1:%2").arg(size.width()).arg(size.height()),
+                                 "-pix_fmt", "yuv420p",
+                                 "-f", "rawvideo", "pipe:1" });
+
+    std::vector<QVideoFrame> wFrames;
+    const qsizetype wFrameBytes = static_cast<qsizetype>(size.width()) * size.height() * 3 / 2;
+    const double wFrameUs = 1000000.0 / fps;
+    QByteArray wBuffer;
+    auto wTakeFrames = [&]() {
+      qsizetype wOffset = 0;
+      for (; wBuffer.size() - wOffset >= wFrameBytes; wOffset += wFrameBytes)
+      {
+        const qint64 wStartTime = start.ms() * 1000 + std::llround(wFrames.size() * wFrameUs);
+        wFrames.push_back(utils::yuv420pFrame(wBuffer.constData() + wOffset, size, wStartTime, wStartTime + std::llround(wFrameUs)));
+      }
+      wBuffer.remove(0, wOffset);
+    };
+
+    if (wProcess.waitForStarted())
+    {
+      while (wProcess.state() != QProcess::NotRunning || wProcess.bytesAvailable() > 0)
+      {
+        if (cancelled(generation))
+        {
+          wProcess.kill();
+          wProcess.waitForFinished(1000);
+          return;
+        }
+        if (wProcess.bytesAvailable() > 0 || wProcess.waitForReadyRead(100))
+        {
+          wBuffer += wProcess.readAllStandardOutput();
+          wTakeFrames();
+        }
+      }
+    }
+
+    ReversePlayer* wOwner = mOwner;
+    QMetaObject::invokeMethod(wOwner, [wOwner, generation, start, wFrames]() {
+      wOwner->onDecoded(generation, start, wFrames);
+      }, Qt::QueuedConnection);
+  }
+
+private:
+  bool cancelled(const quint64 generation) const
+  {
+    return generation != mGeneration.load(std::memory_order_relaxed);
+  }
+
+  ReversePlayer* mOwner = nullptr;
+  const std::atomic<quint64>& mGeneration;
+};
+
+ReversePlayer::ReversePlayer(const QString& ffmpegPath, VideoPlayer* player, const KeyframeIndex* keyframes, QObject* parent)
+  : QObject(parent)
+  , mFFMpegPath(ffmpegPath)
+  , mPlayer(player)
+  , mKeyframes(keyframes)
+  , mWorker(new Worker(this, mGeneration))
+{
+  mThread.setObjectName("ReversePlayer");
+  mWorker->moveToThread(&mThread);
+  mThread.start();
+
+  connect(&mTimer, &QTimer::timeout, this, &ReversePlayer::present);
+}
+
+ReversePlayer::~ReversePlayer()
+{
+  stop();
+  mThread.quit();
+  mThread.wait();
+  delete mWorker;
+}
+
+void ReversePlayer::start(const QUrl& video, const VTime& position, const VTime& stopPosition, const double fps, const double rate)
+{
+  if (!isPreloaded(video, position, stopPosition))
+  {
+    preload(video, position, stopPosition, fps);
+    if (!mCurrent)
+    {
+      return;
+    }
+  }
+
+  mTimer.stop();
+  mRate = std::max(0.01, rate);
+  mAnchorPosition = position;
+  mClockRunning = false;
+  mShownTime = -1;
+  mTimer.start(std::max(10, static_cast<int>(1000.0 / (mFps * mRate))));
+}
+
+void ReversePlayer::preload(const QUrl& video, const VTime& position, const VTime& stopPosition, const double fps)
+{
+  stop();
+
+  // even sizes for the chroma planes
+  const QSize wSource = mPlayer->videoDimensions();
+  if (wSource.isEmpty())
+  {
+    return;
+  }
+  const int wHeight = std::min(wSource.height(), mMaxHeight) & ~1;
+  mOutputSize = QSize(static_cast<int>(std::lround(static_cast<double>(wSource.width()) * wHeight / wSource.height())) & ~1, wHeight);
+
+  mVideo = video;
+  mFps = fps > 0.0 ? fps : 30.0;
+  mStopPosition = stopPosition;
+  mStartPosition = position;
+
+  // the frame on screen is the first one shown
+  request(gopBefore(position + VTime(static_cast<qint64>(std::ceil(1000.0 / mFps)))));
+  requestPrevious();
+}
+
+bool ReversePlayer::isPreloaded(const QUrl& video, const VTime& position, const VTime& stopPosition) const
+{
+  return !isRunning() && mCurrent && mVideo == video && mStartPosition == position && mStopPosition == stopPosition;
+}
+
+void ReversePlayer::stop()
+{
+  ++mGeneration;
+  mTimer.stop();
+  mCurrent.reset();
+  mPrevious.reset();
+  mShownTime = -1;
+  mClockRunning = false;
+}
+
+bool ReversePlayer::isRunning() const
+{
+  return mTimer.isActive();
+}
+
+void ReversePlayer::setRate(const double rate)
+{
+  if (!isRunning())
+  {
+    mRate = std::max(0.01, rate);
+    return;
+  }
+  mAnchorPosition = clockPosition();
+  mClock.restart();
+  mRate = std::max(0.01, rate);
+  mTimer.setInterval(std::max(10, static_cast<int>(1000.0 / (mFps * mRate))));
+}
+
+void ReversePlayer::setMaxHeight(const int height)
+{
+  mMaxHeight = std::max(2, height);
+}
+
+ReversePlayer::Gop ReversePlayer::gopBefore(const VTime& end) const
+{
+  VTime wStart = end > VTime(sMaxChunkMs) ? end - VTime(sMaxChunkMs) : VTime(0);
+  if (mKeyframes != nullptr && mKeyframes->isReady(mVideo))
+  {
+    wStart = std::max(wStart, mKeyframes->atOrBefore(end - VTime(1)).value_or(VTime(0)));
+  }
+
+  Gop wGop;
+  wGop.mStart = std::max(wStart, mStopPosition);
+  wGop.mEnd = end;
+  return wGop;
+}
+
+void ReversePlayer::request(const Gop& gop)
+{
+  if (mCurrent)
+  {
+    mPrevious = gop;
+  }
+  else
+  {
+    mCurrent = gop;
+  }
+
+  Worker* wWorker = mWorker;
+  const quint64 wGeneration = mGeneration;
+  const QString wFFMpegPath = mFFMpegPath;
+  const QString wVideoPath = mVideo.toLocalFile();
+  const QSize wSize = mOutputSize;
+  const double wFps = mFps;
+  QMetaObject::invokeMethod(wWorker, [wWorker, wGeneration, wFFMpegPath, wVideoPath, gop, wSize, wFps]() {
+    wWorker->decode(wGeneration, wFFMpegPath, wVideoPath, gop.mStart, gop.mEnd, wSize, wFps);
+    }, Qt::QueuedConnection);
+}
+
+void ReversePlayer::requestPrevious()
+{
+  if (!mCurrent || mPrevious || mCurrent->mStart <= mStopPosition)
+  {
+    return;
+  }
+  request(gopBefore(mCurrent->mStart));
+}
+
+void ReversePlayer::onDecoded(const quint64 generation, const VTime& start, std::vector<QVideoFrame> frames)
+{
+  if (generation != mGeneration)
+  {
+    return;
+  }
+
+  std::optional<Gop>& wGop = mCurrent && mCurrent->mStart == start && !mCurrent->mReady ? mCurrent : mPrevious;
+  if (!wGop || wGop->mStart != start)
+  {
+    return;
+  }
+  wGop->mFrames = std::move(frames);
+  wGop->mReady = true;
+  if (wGop->mFrames.empty() && &wGop == &mCurrent)
+  {
+    const bool wRunning = isRunning(); // a preload just drops it, start decodes again
+    stop(); // nothing decodable, e.g. the video ended
+    if (wRunning)
+    {
+      emit finished();
+    }
+  }
+}
+
+VTime ReversePlayer::clockPosition() const
+{
+  if (!mClockRunning)
+  {
+    return mAnchorPosition;
+  }
+  const VTime wElapsed(static_cast<qint64>(mClock.elapsed() * mRate));
+  return mAnchorPosition > wElapsed ? mAnchorPosition - wElapsed : VTime(0);
+}
+
+void ReversePlayer::present()
+{
+  if (!mCurrent || !mCurrent->mReady)
+  {
+    return; // the clock starts with the first decoded gop
+  }
+  if (!mClockRunning)
+  {
+    mClock.start();
+    mClockRunning = true;
+  }
+
+  VTime wPosition = clockPosition();
+  while (wPosition < mCurrent->mStart && mCurrent->mStart > mStopPosition)
+  {
+    if (mPrevious && mPrevious->mReady && mPrevious->mFrames.empty())
+    {
+      stop(); // the decode failed, there is nothing to go back to
+      emit finished();
+      return;
+    }
+    if (!mPrevious || !mPrevious->mReady)
+    {
+      // the decoder is behind, the picture waits on the first frame of the gop and the clock restarts from there
+      wPosition = mCurrent->mStart;
+      mAnchorPosition = wPosition;
+      mClockRunning = false;
+      break;
+    }
+    mCurrent = std::move(mPrevious);
+    mPrevious.reset();
+    requestPrevious();
+  }
+
+  // the last frame starting at or before the clock
+  const qint64 wTime = std::max(wPosition, mStopPosition).ms() * 1000;
+  auto wIt = std::upper_bound(mCurrent->mFrames.begin(), mCurrent->mFrames.end(), wTime, [](const qint64 time, const QVideoFrame& frame) {
+    return time < frame.startTime();
+    });
+  const QVideoFrame& wFrame = wIt == mCurrent->mFrames.begin() ? mCurrent->mFrames.front() : *std::prev(wIt);
+  if (wFrame.startTime() != mShownTime)
+  {
+    mShownTime = wFrame.startTime();
+    mPlayer->present(wFrame);
+  }
+
+  if (wPosition <= mStopPosition)
+  {
+    stop();
+    emit finished();
+  }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Types.h"
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QSize>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QVideoFrame>
+
+#include <atomic>
+#include <optional>
+#include <vector>
+
+class VideoPlayer;
+class KeyframeIndex;
+
+// plays backward: ffmpeg decodes a gop forward on a worker thread, its frames are presented from the last to the first
+// the gop before the one on screen is decoded meanwhile, the presentation follows the wall clock and skips the late frames
+// the frames are scaled down to Settings::mReverseMaxHeight, two gops are kept in memory
+class ReversePlayer : public QObject
+{
+  Q_OBJECT
+
+public:
+  ReversePlayer(const QString& ffmpegPath, VideoPlayer* player, const KeyframeIndex* keyframes, QObject* parent = nullptr);
+  ~ReversePlayer();
+
+  // from position back to stopPosition (e.g. the start of a range entry), the video is the file the player shows
+  void start(const QUrl& video, const VTime& position, const VTime& stopPosition, const double fps, const double rate);
+  // decodes the first gops of a start with the same arguments ahead, e.g. while the loop still plays forward
+  void preload(const QUrl& video, const VTime& position, const VTime& stopPosition, const double fps);
+  void stop();
+  bool isRunning() const;
+
+  void setRate(const double rate);
+  void setMaxHeight(const int height);
+
+signals:
+  void finished(); // reached the stop position
+
+private:
+  class Worker;
+
+  struct Gop
+  {
+    VTime mStart;
+    VTime mEnd;
+    bool mReady = false;
+    std::vector<QVideoFrame> mFrames; // in presentation order
+  };
+
+  bool isPreloaded(const QUrl& video, const VTime& position, const VTime& stopPosition) const;
+  Gop gopBefore(const VTime& end) const; // the chunk ending at end, starting on a keyframe when the index is ready
+  void request(const Gop& gop);
+  void requestPrevious();
+  void onDecoded(const quint64 generation, const VTime& start, std::vector<QVideoFrame> frames);
+  void present();
+  VTime clockPosition() const;
+
+  const QString mFFMpegPath;
+  VideoPlayer* mPlayer = nullptr;
+  const KeyframeIndex* mKeyframes = nullptr;
+
+  QThread mThread;
+  Worker* mWorker = nullptr; // lives on mThread
+  std::atomic<quint64> mGeneration{ 0 }; // a decode of a stopped playback is abandoned
+
+  QUrl mVideo;
+  QSize mOutputSize;
+  int mMaxHeight = 720;
+  double mFps = 30.0;
+  double mRate = 1.0;
+  VTime mStopPosition;
+  VTime mStartPosition;
+
+  std::optional<Gop> mCurrent;  // on screen
+  std::optional<Gop> mPrevious; // being decoded, or waiting for its turn
+  qint64 mShownTime = -1;       // us
+
+  QTimer mTimer;
+  QElapsedTimer mClock;
+  bool mClockRunning = false; // stopped while the gop to show is not decoded yet
+  VTime mAnchorPosition;      // where the clock was started
+
+  static constexpr qint64 sMaxChunkMs = 3000; // longer gops are split, the decode starts on their keyframe anyway
+};
@@ -0,0 +1,178 @@
+#include "SeekTargets.h"
+#include "KeyframeIndex.h"
+#include "Utils.h"
+
+#include <QProcess>
+
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#endif
+
+class SeekTargets::Worker : public QObject
+{
+public:
+  Worker(SeekTargets* owner, const std::atomic<quint64>& generation)
+    : mOwner(owner)
+    , mGeneration(generation)
+  {}
+
+  void decode(const quint64 generation, const bool forward, const QString& ffmpegPath, const QString& videoPath, const VTime& position, const QSize& size)
+  {
+    if (generation != mGeneration.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+
+    // the seek before the input decodes from the keyframe and drops what is before the position
+    QProcess wProcess;
+#ifdef Q_OS_WIN
+    wProcess.setCreateProcessArgumentsModifier([](QProcess::CreateProcessArguments* arguments) {
+      arguments->flags |= BELOW_NORMAL_PRIORITY_CLASS;
+      });
+#endif
+    wProcess.setStandardErrorFile(QProcess::nullDevice());
+    wProcess.start(ffmpegPath, { "-hide_banner", "-loglevel", "error",
+                                 "-ss", position.toString(),
+                                 "-i", videoPath,
+                                 "-frames:v", "1",
+                                 "-an", "-sn",
+                                 "-vf", QString("scale=%1:%2").arg(size.width()).arg(size.height()),
+                                 "-pix_fmt", "yuv420p",
+                                 "-f", "rawvideo", "pipe:1" });
+
+    QVideoFrame wFrame;
+    if (wProcess.waitForFinished(10000) && wProcess.exitCode() == 0)
+    {
+      const QByteArray wOutput = wProcess.readAllStandardOutput();
+      if (wOutput.size() >= static_cast<qsizetype>(size.width()) * size.height() * 3 / 2)
+      {
+        const qint64 wStartTime = position.ms() * 1000;
+        wFrame = utils::yuv420pFrame(wOutput.constData(), size, wStartTime, wStartTime + 1000); // the player's frame replaces it
+      }
+    }
+    else
+    {
+      wProcess.kill();
+      wProcess.waitForFinished(1000);
+    }
+
+    SeekTargets* wOwner = mOwner;
+    QMetaObject::invokeMethod(wOwner, [wOwner, generation, forward, wFrame]() {
+      wOwner->onDecoded(generation, forward, wFrame);
+      }, Qt::QueuedConnection);
+  }
+
+private:
+  SeekTargets* mOwner = nullptr;
+  const std::atomic<quint64>& mGeneration;
+};
+
+SeekTargets::SeekTargets(const QString& ffmpegPath, const KeyframeIndex* keyframes, QObject* parent)
+  : QObject(parent)
+  , mFFMpegPath(ffmpegPath)
+  , mKeyframes(keyframes)
+  , mWorker(new Worker(this, mGeneration))
+{
+  mThread.setObjectName("SeekTargets");
+  mWorker->moveToThread(&mThread);
+  mThread.start();
+}
+
+SeekTargets::~SeekTargets()
+{
+  clear();
+  mThread.quit();
+  mThread.wait();
+  delete mWorker;
+}
+
+void SeekTargets::prepare(const QUrl& video, const QSize& size, const VTime& position, const VTime& duration)
+{
+  clear();
+  if (video.isEmpty() || size.isEmpty() || duration <= VTime(0))
+  {
+    return;
+  }
+
+  mVideo = video;
+  mSize = QSize(size.width() & ~1, size.height() & ~1); // even sizes for the chroma planes
+  mForward.mPosition = choose(true, position, duration);
+  mBackward.mPosition = choose(false, position, duration);
+  request(true);
+  request(false);
+}
+
+void SeekTargets::clear()
+{
+  ++mGeneration;
+  mVideo.clear();
+  mForward = Slot();
+  mBackward = Slot();
+}
+
+SeekTargets::Target SeekTargets::take(const bool forward, const QUrl& video, const VTime& position, const VTime& duration)
+{
+  // playing on may have passed the target, it is not in the direction of the jump anymore
+  Slot& wSlot = forward ? mForward : mBackward;
+  const bool wValid = video == mVideo && wSlot.mPosition && (forward ? *wSlot.mPosition > position : *wSlot.mPosition < position);
+  Target wTarget;
+  if (wValid)
+  {
+    wTarget.mPosition = *wSlot.mPosition;
+    wTarget.mFrame = wSlot.mFrame;
+  }
+  else
+  {
+    wTarget.mPosition = choose(forward, position, duration);
+  }
+  wSlot = Slot();
+  return wTarget;
+}
+
+VTime SeekTargets::choose(const bool forward, const VTime& position, const VTime& duration) const
+{
+  // somewhere in the next or the previous fifth of the video, at least 10 ms away
+  const VTime wWindow = VTime(static_cast<qint64>(duration.ms() / 5.0));
+  const qint64 wMax = std::max<qint64>(10, forward ? std::min(wWindow, duration - position).ms() : std::min(wWindow, position).ms());
+  const VTime wStep = VTime(utils::Random<qint64>(10, wMax));
+  VTime wTarget = forward ? std::min(position + wStep, duration) : (position > wStep ? position - wStep : VTime(0));
+
+  // a keyframe decodes in one step, for the player as well, if there is one on the right side
+  if (mKeyframes != nullptr && mKeyframes->isReady(mVideo))
+  {
+    const VTime wKeyframe = mKeyframes->nearest(wTarget);
+    if (forward ? wKeyframe > position : wKeyframe < position)
+    {
+      wTarget = wKeyframe;
+    }
+  }
+  return wTarget;
+}
+
+void SeekTargets::request(const bool forward)
+{
+  Worker* wWorker = mWorker;
+  const quint64 wGeneration = mGeneration;
+  const QString wFFMpegPath = mFFMpegPath;
+  const QString wVideoPath = mVideo.toLocalFile();
+  const VTime wPosition = *(forward ? mForward : mBackward).mPosition;
+  const QSize wSize = mSize;
+  QMetaObject::invokeMethod(wWorker, [wWorker, wGeneration, forward, wFFMpegPath, wVideoPath, wPosition, wSize]() {
+    wWorker->decode(wGeneration, forward, wFFMpegPath, wVideoPath, wPosition, wSize);
+    }, Qt::QueuedConnection);
+}
+
+void SeekTargets::onDecoded(const quint64 generation, const bool forward, const QVideoFrame& frame)
+{
+  if (generation != mGeneration)
+  {
+    return;
+  }
+  Slot& wSlot = forward ? mForward : mBackward;
+  if (wSlot.mPosition)
+  {
+    wSlot.mFrame = frame;
+  }
+}
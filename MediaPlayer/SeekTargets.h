@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Types.h"
+
+#include <QObject>
+#include <QSize>
+#include <QThread>
+#include <QUrl>
+#include <QVideoFrame>
+
+#include <atomic>
+#include <optional>
+
+class KeyframeIndex;
+
+// the next random seek of both directions, chosen ahead and decoded by ffmpeg on a worker thread
+// the jump shows the decoded frame right away, the player seeks behind it, on a keyframe when the index is ready
+class SeekTargets : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Target
+  {
+    VTime mPosition;
+    QVideoFrame mFrame; // invalid while it is decoded
+  };
+
+  SeekTargets(const QString& ffmpegPath, const KeyframeIndex* keyframes, QObject* parent = nullptr);
+  ~SeekTargets();
+
+  // replaces both targets, around position, the frames are decoded at size
+  void prepare(const QUrl& video, const QSize& size, const VTime& position, const VTime& duration);
+  void clear();
+
+  // the prepared target of the direction, a new one if there is none in front of the position
+  Target take(const bool forward, const QUrl& video, const VTime& position, const VTime& duration);
+
+private:
+  class Worker;
+
+  struct Slot
+  {
+    std::optional<VTime> mPosition;
+    QVideoFrame mFrame;
+  };
+
+  VTime choose(const bool forward, const VTime& position, const VTime& duration) const;
+  void request(const bool forward);
+  void onDecoded(const quint64 generation, const bool forward, const QVideoFrame& frame);
+
+  const QString mFFMpegPath;
+  const KeyframeIndex* mKeyframes = nullptr;
+
+  QThread mThread;
+  Worker* mWorker = nullptr; // lives on mThread
+  std::atomic<quint64> mGeneration{ 0 }; // the decodes of replaced targets are abandoned
+
+  QUrl mVideo;
+  QSize mSize;
+  Slot mForward;
+  Slot mBackward;
+};
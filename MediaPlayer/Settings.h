@@ -1,5 +1,9 @@
 #pragma once
 
+#include <QRectF>
+#include <QString>
+
+#include <map>
 #include <vector>
 #include <string>
 
@@ -13,9 +17,83 @@ struct Settings
     Last
   };
 
+  enum class AnimationFormat : unsigned
+  {
+    WebP = 0,
+    Gif
+  };
+
+  enum class ImageFormat : unsigned
+  {
+    Png = 0,
+    Jpeg,
+    WebP
+  };
+
+  enum class BatchTemplate : unsigned
+  {
+    Head = 0,  // first N sec
+    Tail,      // last N sec
+    Middle     // N sec around the midpoint
+  };
+
   bool mAutoPlay = false;
   AudioMode mAudioMode = AudioMode::Muted;
   int mCursorTimeout = 1000;
   float mVolume = 0.0f;
   bool mRandomize = false;
+  bool mPrewarmNext = true; // the next entry of the playlist is opened in the background, next swaps to it
+
+  int mFrameRingMB = 256; // the frames kept for frame steps, the playback on the gpu leaves only its last few, see FrameRing
+  int mReverseMaxHeight = 720; // the reverse playback decodes at most this size, see ReversePlayer
+  double mKeyframeRate = 3.0;  // faster playback and shuttle decode only the keyframes, see DecodeStrategy
+  bool mPredecodeSeeks = true; // the next random seek of both directions is decoded ahead, see SeekTargets
+
+  // multi-view, see GridPlayer
+  int mGridDecodeBudget = 60; // frames per second of all the tiles together
+  int mGridTileHeight = 270;  // the tiles are decoded at this height, 16:9
+
+  // page cache warm-up of the upcoming entries, see Prefetcher
+  int mPrefetchCount = 3;     // 0 disables it
+  int mPrefetchHeadMB = 4;    // read from the start of every file, next to its index
+  int mPrefetchBudgetMB = 64; // for all the files together
+  std::vector<int> mRenditionHeights = { 1080, 720, 360 }; // output heights of the ladder cut, one decode feeds all of them
+
+  // encode filters, see FilterChain
+  QRectF mCrop = QRectF(0.0, 0.0, 1.0, 1.0); // normalized to the source frame
+  int mOutputHeight = 0;     // 0 keeps the source size
+  double mOutputFps = 0.0;   // 0 keeps the source frame rate
+  double mOutputSpeed = 1.0;
+  bool mNormalizeAudio = false;
+
+  // time-lapse cut, only keyframes are decoded
+  double mTimeLapseSpeed = 20.0;
+  int mTimeLapseKeyframeStep = 1; // every Nth keyframe
+  double mTimeLapseFps = 30.0;
+
+  // animated preview export
+  AnimationFormat mAnimationFormat = AnimationFormat::WebP;
+  int mAnimationWidth = 480;
+  double mAnimationFps = 15.0;
+
+  int mTargetSizeMB = 50; // size cap of the sized cut, audio included
+
+  // still frames and frame range export
+  ImageFormat mImageFormat = ImageFormat::Png;
+  int mFrameStep = 1; // every Nth frame of the range
+
+  bool mFragmentedOutput = true; // fragmented mp4 with 1 sec keyframes, in progress cuts can be previewed
+  bool mSpeculativeCut = true;   // a marked sequence is fast cut in the background before it is asked for
+  bool mChapterRemux = true;     // the chapter export writes a chapter marked copy of the video too, not only the chapter file
+
+  // batch cut of the whole playlist
+  BatchTemplate mBatchTemplate = BatchTemplate::Head;
+  double mBatchLength = 15.0; // sec
+
+  // encoder job limits, a disk serves only a few concurrent streams before it starts seeking between them
+  int mMaxJobs = 4;
+  int mReadersPerDevice = 2;
+  int mWritersPerDevice = 2;
+  int mThreadBudget = 0; // encoder threads shared by the running jobs, 0 is one per logical core
+  std::map<QString, int> mDeviceReaderLimits; // learned concurrent readers by device type ("hdd", "ssd", ...)
 };
@@ -0,0 +1,177 @@
+#include "SizePredictor.h"
+
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+SizePredictor::SizePredictor(const QString& ffmpegPath, JobQueue* jobs, QObject* parent)
+  : QObject(parent)
+  , mFFMpegPath(ffmpegPath)
+  , mJobs(jobs)
+{
+  connect(mJobs, &JobQueue::jobFinished, this, &SizePredictor::onJobFinished);
+}
+
+SizePredictor::~SizePredictor()
+{
+  cancelSamples();
+}
+
+void SizePredictor::setGpuEncode(const bool gpuEncode)
+{
+  mGpuEncode = gpuEncode;
+}
+
+void SizePredictor::setFilterArguments(const QStringList& filterArguments)
+{
+  mFilterArguments = filterArguments;
+}
+
+QStringList SizePredictor::rateArguments(double crf) const
+{
+  const QString wQuality = QString::number(std::clamp(crf, 0.0, 51.0), 'f', 1);
+  if (mGpuEncode)
+  {
+    return { "-rc", "vbr", "-cq", wQuality, "-b:v", "0" };
+  }
+  return { "-crf", wQuality };
+}
+
+void SizePredictor::predict(const QString& videoPath, const VTime& startTime, const VTime& endTime, qint64 targetBytes, qint64 audioBitrate)
+{
+  mDuration = endTime - startTime;
+  mTargetBytes = targetBytes;
+  mAudioBitrate = audioBitrate;
+  cancelSamples();
+  mSamples.clear();
+  mFinishedCount = 0;
+
+  if (mDuration.ms() <= 0 || mTargetBytes <= 0)
+  {
+    emit failed("Invalid range or target size");
+    return;
+  }
+  if (!mSampleDirectory.isValid())
+  {
+    emit failed("No temporary directory for the samples");
+    return;
+  }
+
+  // the samples are a fixed fraction of the range, but not shorter than a few GOPs worth of frames
+  const VTime wSpacing = VTime(mDuration.ms() / sSampleCount);
+  const VTime wSampleLength = VTime(std::clamp<qint64>(static_cast<qint64>(mDuration.ms() * sSampleFraction / sSampleCount), std::min<qint64>(500, wSpacing.ms()), wSpacing.ms()));
+
+  for (const double wCrf : { sLowCrf, sHighCrf })
+  {
+    for (unsigned i = 0; i < sSampleCount; ++i)
+    {
+      // centered in the i-th slice of the range
+      const VTime wSampleStart = startTime + wSpacing * static_cast<double>(i) + VTime((wSpacing.ms() - wSampleLength.ms()) / 2);
+
+      const size_t wSampleIndex = mSamples.size();
+      mSamples.push_back(Sample{ wCrf, wSampleLength, mSampleDirectory.filePath(QString("%1.h264").arg(wSampleIndex)) });
+
+      Job wJob;
+      wJob.mName = QString("Size sample %1 at crf %2").arg(i + 1).arg(wCrf);
+      wJob.mProgram = mFFMpegPath;
+      wJob.mArguments = { "-hide_banner", "-loglevel", "info", "-y" };
+      if (mGpuEncode)
+      {
+        wJob.mArguments.append({ "-hwaccel", "cuda" });
+      }
+      wJob.mArguments.append({ "-ss", wSampleStart.toString(), "-t", wSampleLength.toString(), "-i", videoPath });
+      wJob.mArguments.append(mFilterArguments);
+      wJob.mArguments.append({ "-an", "-c:v", mGpuEncode ? "h264_nvenc" : "libx264", "-threads", Job::sThreadCount });
+      wJob.mArguments.append(rateArguments(wCrf));
+      wJob.mArguments.append({ "-f", "h264", mSamples.back().mFilePath }); // no container, only the encoded size is needed
+      wJob.mSourcePath = videoPath;
+      wJob.mDestinationPath = mSamples.back().mFilePath;
+      wJob.mDuration = wSampleLength;
+      wJob.mBulk = true;
+      mRunning.emplace(mJobs->submit(wJob), wSampleIndex);
+    }
+  }
+}
+
+void SizePredictor::cancelSamples()
+{
+  // a pending job reports its end right away, it is not ours anymore by then
+  const std::map<Job::Id, size_t> wRunning = std::exchange(mRunning, {});
+  for (const auto& wJob : wRunning)
+  {
+    mJobs->cancel(wJob.first);
+  }
+}
+
+void SizePredictor::onJobFinished(const Job::Id id, const bool succeeded)
+{
+  auto wIt = mRunning.find(id);
+  if (wIt == mRunning.end())
+  {
+    return;
+  }
+  Sample& wSample = mSamples[wIt->second];
+  mRunning.erase(wIt);
+
+  const QFileInfo wFileInfo(wSample.mFilePath);
+  if (succeeded && wFileInfo.exists())
+  {
+    wSample.mBytes = wFileInfo.size();
+  }
+  onSampleFinished();
+}
+
+void SizePredictor::onSampleFinished()
+{
+  if (++mFinishedCount < mSamples.size())
+  {
+    return;
+  }
+
+  // bitrate of each quality level over all of its samples
+  double wLowBytes = 0.0, wHighBytes = 0.0;
+  double wLowSeconds = 0.0, wHighSeconds = 0.0;
+  for (const Sample& wSample : mSamples)
+  {
+    if (wSample.mBytes <= 0)
+    {
+      continue;
+    }
+    const bool wLow = wSample.mCrf == sLowCrf;
+    (wLow ? wLowBytes : wHighBytes) += static_cast<double>(wSample.mBytes);
+    (wLow ? wLowSeconds : wHighSeconds) += wSample.mLength.ms() / 1000.0;
+  }
+
+  if (wLowSeconds <= 0.0 || wHighSeconds <= 0.0 || wLowBytes <= 0.0 || wHighBytes <= 0.0)
+  {
+    emit failed("Sample encodes failed");
+    return;
+  }
+
+  const double wLowRate = wLowBytes / wLowSeconds;
+  const double wHighRate = wHighBytes / wHighSeconds;
+  if (wHighRate >= wLowRate)
+  {
+    emit failed("Samples are not compressible enough for a prediction");
+    return;
+  }
+
+  // log(rate) = a + b * crf
+  const double wSlope = (std::log(wHighRate) - std::log(wLowRate)) / (sHighCrf - sLowCrf);
+  const double wSeconds = mDuration.ms() / 1000.0;
+  const double wVideoBytes = static_cast<double>(mTargetBytes) - mAudioBitrate / 8.0 * wSeconds;
+  if (wVideoBytes <= 0.0)
+  {
+    emit failed("Target size is smaller than the audio alone");
+    return;
+  }
+
+  const double wTargetRate = wVideoBytes / wSeconds;
+  const double wCrf = std::clamp(sLowCrf + (std::log(wTargetRate) - std::log(wLowRate)) / wSlope, 0.0, 51.0);
+  const double wPredictedRate = std::exp(std::log(wLowRate) + wSlope * (wCrf - sLowCrf));
+  const qint64 wPredictedBytes = static_cast<qint64>(wPredictedRate * wSeconds + mAudioBitrate / 8.0 * wSeconds);
+
+  emit predicted(wCrf, wPredictedBytes);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "JobQueue.h"
+#include "VTime.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <map>
+#include <vector>
+
+// encodes a few short, evenly spaced samples of a range at two quality levels in parallel and fits
+// log(bitrate) = a + b * crf on them, the crf hitting the target size is then used for the one full encode
+// the samples are bulk jobs of the queue, they get their share of the thread budget and give way to the playback like the batch cuts
+class SizePredictor : public QObject
+{
+  Q_OBJECT
+
+public:
+  SizePredictor(const QString& ffmpegPath, JobQueue* jobs, QObject* parent = nullptr);
+  ~SizePredictor();
+
+  void setGpuEncode(const bool gpuEncode);
+  void setFilterArguments(const QStringList& filterArguments); // -vf of the full encode, samples must see the same frames
+
+  // targetBytes covers the whole file, audioBitrate (bits/s) is reserved from it
+  void predict(const QString& videoPath, const VTime& startTime, const VTime& endTime, qint64 targetBytes, qint64 audioBitrate);
+
+  QStringList rateArguments(double crf) const; // encoder arguments for the predicted quality
+
+signals:
+  void predicted(double crf, qint64 predictedBytes);
+  void failed(const QString& reason);
+
+private:
+  struct Sample
+  {
+    double mCrf = 0.0;
+    VTime mLength;
+    QString mFilePath; // the raw stream, its size is the size of the encoded video
+    qint64 mBytes = -1;
+  };
+
+  void cancelSamples();
+  void onJobFinished(const Job::Id id, const bool succeeded);
+  void onSampleFinished();
+
+  const QString mFFMpegPath;
+  JobQueue* mJobs = nullptr;
+  bool mGpuEncode = false;
+  QStringList mFilterArguments;
+
+  VTime mDuration;
+  qint64 mTargetBytes = 0;
+  qint64 mAudioBitrate = 0;
+
+  std::vector<Sample> mSamples;
+  std::map<Job::Id, size_t> mRunning; // sample index of the jobs not finished yet
+  QTemporaryDir mSampleDirectory;     // removed with the samples
+  size_t mFinishedCount = 0;
+
+  static constexpr unsigned sSampleCount = 4;
+  static constexpr double sSampleFraction = 0.04;  // of the range, per quality level
+  static constexpr double sLowCrf = 20.0;
+  static constexpr double sHighCrf = 32.0;
+};
@@ -20,6 +20,7 @@ const std::map<QString, const QColor> Slider::sColorMap = {
   { "progressEnd",        QColor(34, 115, 211, 185)},
   { "invalid",            QColor(255, 0, 0, 155) },
   { "ready",              QColor(255, 255, 255, 55) },
+  { "queued",             QColor(255, 255, 255, 105) },
   { "processing",         QColor(255, 255, 255, 155) },
   { "succeeded",          QColor(40, 185,  70, 155) },
   { "failed",             QColor(255,  20,  78, 155) },
@@ -211,6 +212,9 @@ const QColor& Slider::sequenceColor(const SequenceEntry& wSequenceEntry) const
     case OperationState::Ready:
       colorName = "ready";
       break;
+    case OperationState::Queued:
+      colorName = "queued";
+      break;
     case OperationState::Processing:
       colorName = "processing";
       break;
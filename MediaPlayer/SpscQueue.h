@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <utility>
+
+// bounded lock-free queue of one producer and one consumer thread
+// push and the ones marked so are only called by the producer, pop only by the consumer, neither of them ever waits for the other
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "the capacity must be a power of two");
+
+public:
+  // false if the queue is full, the value is left untouched then
+  bool push(T&& value)
+  {
+    const size_t wTail = mTail.load(std::memory_order_relaxed);
+    if (wTail - mHead.load(std::memory_order_acquire) == Capacity)
+    {
+      return false;
+    }
+    mSlots[wTail & (Capacity - 1)] = std::move(value);
+    mTail.store(wTail + 1, std::memory_order_release); // publishes the slot written above
+    return true;
+  }
+
+  // producer only, the value is kept in order while the queue is full, flush hands it over later
+  // returns false if something is kept, the producer has to call flush again
+  bool pushOrKeep(T&& value)
+  {
+    if (flush() && push(std::move(value)))
+    {
+      return true;
+    }
+    mKept.push_back(std::move(value));
+    return false;
+  }
+
+  // producer only, true if nothing is kept anymore
+  bool flush()
+  {
+    while (!mKept.empty() && push(std::move(mKept.front())))
+    {
+      mKept.pop_front();
+    }
+    return mKept.empty();
+  }
+
+  // false if the queue is empty
+  bool pop(T& value)
+  {
+    const size_t wHead = mHead.load(std::memory_order_relaxed);
+    if (mTail.load(std::memory_order_acquire) == wHead)
+    {
+      return false;
+    }
+    value = std::move(mSlots[wHead & (Capacity - 1)]);
+    mHead.store(wHead + 1, std::memory_order_release); // gives the slot back to the producer
+    return true;
+  }
+
+private:
+  // the counters only grow, the slot is the counter modulo the capacity, they are on separate cache lines
+  // so the two threads do not invalidate each other's line on every operation
+  alignas(64) std::atomic<size_t> mHead{ 0 };
+  alignas(64) std::atomic<size_t> mTail{ 0 };
+  alignas(64) std::array<T, Capacity> mSlots;
+  std::deque<T> mKept; // producer side
+};
@@ -13,6 +13,7 @@ using Sequence = std::pair<VTime, VTime>;
 enum class OperationState
 {
   Ready,
+  Queued,     // waiting for a free encoder slot
   Processing,
   Succeeded,
   Failed
@@ -27,6 +28,7 @@ struct SequenceState
     mSelected = other.mSelected;
     mIsEditing = other.mIsEditing;
     mFilePath = other.mFilePath;
+    mFragmented = other.mFragmented;
     mProcessTimer = other.mProcessTimer;
   }
 
@@ -34,6 +36,7 @@ struct SequenceState
   bool mSelected = false;
   bool mIsEditing = false;
   QString mFilePath; // just the file name at the time of being cut. user must check if the file really exists!
+  bool mFragmented = false; // the output is playable while it is written, see MediaPlayer::fragmentArguments
   VTime mProcessTimer = VTime(0); // current processing time if in processing state
 };
 
@@ -41,6 +44,36 @@ using SequenceMap = std::map<Sequence, SequenceState>;
 using SequenceEntry = SequenceMap::value_type;
 using SequenceVector = std::vector<Sequence>;
 
+// how the player gets its frames
+enum class DecodeStrategy
+{
+  Full,      // every frame, by the player
+  Keyframes, // the keyframe nearest to the clock, by seeks, for the rates the full decode can not keep up with
+  Reverse    // gops decoded forward and shown backward, see ReversePlayer
+};
+
+// frame delivery of the playback, collected over about a second
+struct PlaybackStatistics
+{
+  unsigned mPresentedFrames = 0;
+  unsigned mDroppedFrames = 0;   // gaps in the presentation timestamps, or keyframes the decoder was too slow for
+  VTime mMaxLateness = VTime(0); // the most a frame came later than the previous one plus its duration
+  DecodeStrategy mStrategy = DecodeStrategy::Full;
+  double mRate = 1.0;            // negative backward
+};
+
+// one scrub, from the first seek request until the picture settled on the last one
+struct SeekStatistics
+{
+  unsigned mRequested = 0;
+  unsigned mIssued = 0;          // the rest was superseded before it reached the player
+  unsigned mKeyframeSeeks = 0;   // of the issued ones, shown while the input was still moving
+  VTime mLatency = VTime(0);     // from issuing the final seek until its frame was shown
+  VTime mMaxLatency = VTime(0);
+  unsigned mTimeouts = 0;        // seeks never shown, they are not in the latency
+  bool mInteractive = false;     // requested by the user input, not by a load or the playback
+};
+
 struct Placement
 {
   QPoint mPosition;
@@ -5,12 +5,26 @@
 #include <QString>
 #include <QColor>
 #include <QRegularExpression>
+#include <QVideoFrame>
+#include <QVideoFrameFormat>
 
+#include <cstring>
 #include <random>
 
 namespace utils
 {
 
+// the tools of the cuts, the job daemon runs nothing else
+inline QString ffmpegPath()
+{
+  return "d:\\Tools\\ffmpeg\\ffmpeg.exe"; // TODO: settings
+}
+
+inline QString ffprobePath()
+{
+  return QFileInfo(ffmpegPath()).absolutePath() + "/ffprobe.exe";
+}
+
 inline QString prettifyFileName(QString fileName)
 {
   fileName.replace(QRegularExpression("[^A-Za-z]"), ".");
@@ -55,6 +69,31 @@ inline T Random(T min, T max)
   }
 }
 
+// a frame of "-pix_fmt yuv420p -f rawvideo" output: y, then u and v at half the size, packed by ffmpeg, padded by the frame
+inline QVideoFrame yuv420pFrame(const char* data, const QSize& size, const qint64 startTime, const qint64 endTime)
+{
+  QVideoFrame wFrame(QVideoFrameFormat(size, QVideoFrameFormat::Format_YUV420P));
+  if (!wFrame.map(QVideoFrame::WriteOnly))
+  {
+    return QVideoFrame();
+  }
+
+  for (int wPlane = 0; wPlane < 3; ++wPlane)
+  {
+    const int wWidth = wPlane == 0 ? size.width() : size.width() / 2;
+    const int wHeight = wPlane == 0 ? size.height() : size.height() / 2;
+    for (int wRow = 0; wRow < wHeight; ++wRow)
+    {
+      std::memcpy(wFrame.bits(wPlane) + wRow * wFrame.bytesPerLine(wPlane), data + wRow * wWidth, wWidth);
+    }
+    data += wWidth * wHeight;
+  }
+  wFrame.unmap();
+  wFrame.setStartTime(startTime);
+  wFrame.setEndTime(endTime);
+  return wFrame;
+}
+
 QColor inline lerp(const QColor& c1, const QColor& c2, double t)
 {
   int r = static_cast<int>(c1.red() + (c2.red() - c1.red()) * t);
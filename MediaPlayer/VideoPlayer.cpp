@@ -1,6 +1,8 @@
 #include "VideoPlayer.h"
 #include "View.h"
 #include "VideoWidget.h"
+#include "Playlist.h"
+#include "KeyframeIndex.h"
 
 #include <QMediaMetaData>
 #include <QMediaPlayer>
@@ -9,19 +11,125 @@
 #include <qvideosink.h> 
 
 #include <random>
+#include <algorithm>
+#include <cmath>
 
 VideoPlayer::VideoPlayer(VideoWidget* videoWidget, QObject* parent)
   : QObject(parent)
+  , mVideoWidget(videoWidget)
 {
   mAudioOutput = new QAudioOutput(this);
+  mStandbySink = new QVideoSink(this);
 
   mVideoPlayer.reset(new QMediaPlayer(this));
   mVideoPlayer->setVideoOutput(videoWidget);
   mVideoPlayer->setAudioOutput(mAudioOutput);
+  connectPlayer(mVideoPlayer.get());
+
+  mStandbyPlayer.reset(new QMediaPlayer(this));
+  mStandbyPlayer->setVideoOutput(mStandbySink); // no audio output, it is silent until it is swapped in
+  connectPlayer(mStandbyPlayer.get());
+
+  // the sink of the widget stays on screen, the players are swapped behind it
+  mFrameClock.start();
+  connect(videoWidget->videoSink(), &QVideoSink::videoFrameChanged, this, &VideoPlayer::onVideoFrame);
+
+  mSettleTimer.setSingleShot(true);
+  mSettleTimer.setInterval(sSettleMs);
+  connect(&mSettleTimer, &QTimer::timeout, this, &VideoPlayer::onSeekSettled);
+  mSeekTimeout.setSingleShot(true);
+  mSeekTimeout.setInterval(sSeekTimeoutMs);
+  connect(&mSeekTimeout, &QTimer::timeout, this, &VideoPlayer::onSeekTimeout);
+
+  mWrapTimer.setSingleShot(true);
+  mWrapTimer.setTimerType(Qt::PreciseTimer);
+  connect(&mWrapTimer, &QTimer::timeout, this, &VideoPlayer::wrapLoop);
+
+  mKeyframeTimer.setInterval(sKeyframeTickMs);
+  mKeyframeTimer.setTimerType(Qt::PreciseTimer);
+  connect(&mKeyframeTimer, &QTimer::timeout, this, &VideoPlayer::onKeyframeTick);
+}
+
+void VideoPlayer::connectPlayer(QMediaPlayer* player)
+{
+  connect(player, &QMediaPlayer::playbackStateChanged, this, [this, player](QMediaPlayer::PlaybackState state) {
+    if (player != mVideoPlayer.get())
+    {
+      return;
+    }
+    mLastFrameTime = -1;
+    emit playingChanged(state == QMediaPlayer::PlayingState || mKeyframeTimer.isActive());
+  });
+
+  connect(player, &QMediaPlayer::positionChanged, this, [this, player](qint64 t) {
+    if (player != mVideoPlayer.get())
+    {
+      return;
+    }
+    if (mKeyframeTimer.isActive())
+    {
+      return; // the ticks report the clock and check the end
+    }
+    emit positionChanged(VTime(t));
+
+    // a range entry ends with its range, the rest of the file is not part of it, a loop ends with the loop
+    const std::optional<Sequence> wRange = mLoop ? mLoop : mRange;
+    if (!wRange)
+    {
+      return;
+    }
+    if (t < wRange->second.ms())
+    {
+      mRangeEnded = false;
+      const qint64 wRemaining = wRange->second.ms() - t;
+      if (mLoop && mLoopWrap && isPlaying() && !mWrapTimer.isActive() && wRemaining <= sWrapLeadMs)
+      {
+        mWrapTimer.start(static_cast<int>(wRemaining / std::max(0.01, mVideoPlayer->playbackRate())));
+      }
+    }
+    else if (!mRangeEnded && isPlaying())
+    {
+      mRangeEnded = true;
+      if (mLoop && mLoopWrap)
+      {
+        wrapLoop(); // the timer was late or the position jumped past the end
+        return;
+      }
+      mVideoPlayer->pause();
+      if (mLoop)
+      {
+        emit loopEnded();
+      }
+      else
+      {
+        emit videoEnded();
+      }
+    }
+  });
+  connect(player, &QMediaPlayer::durationChanged, this, [this, player](qint64 d) {
+    if (player == mVideoPlayer.get())
+    {
+      emit durationChanged(VTime(d));
+    }
+  });
+  connect(player, &QMediaPlayer::mediaStatusChanged, this, [this, player](QMediaPlayer::MediaStatus status) {
+    if (player == mStandbyPlayer.get())
+    {
+      if (status == QMediaPlayer::LoadedMedia && !mStandbyUrl.isEmpty() && !mStandbyLoaded)
+      {
+        // pre-roll: the decoder is opened and the first frame of the entry is decoded, play only starts the clock
+        mStandbyLoaded = true;
+        const std::optional<Sequence> wRange = Playlist::range(mStandbyUrl);
+        player->setPosition(wRange ? wRange->first.ms() : 0);
+        player->pause();
+      }
+      else if (status == QMediaPlayer::InvalidMedia)
+      {
+        mStandbyLoaded = false; // the cold load reports the error
+      }
+      return;
+    }
 
-  connect(mVideoPlayer.get(), &QMediaPlayer::positionChanged, this, [this](qint64 t) { emit positionChanged(VTime(t)); });
-  connect(mVideoPlayer.get(), &QMediaPlayer::durationChanged, this, [this](qint64 d) { emit durationChanged(VTime(d)); });
-  connect(mVideoPlayer.get(), &QMediaPlayer::mediaStatusChanged, this, [this](QMediaPlayer::MediaStatus status) {
     switch (status)
     {
       case QMediaPlayer::NoMedia:
@@ -58,10 +166,127 @@ void VideoPlayer::setVideo(const QUrl& videoUrl)
 {
   if(isPlaying())
   {
+    stopKeyframePlayback();
     mVideoPlayer->stop();
   }
+  mFallBehindRate = 0.0;
+  ++mLoadSerial;
   mIsVideoLoaded = false;
-  mVideoPlayer->setSource(videoUrl);
+  mSettleTimer.stop();
+  mSeekTimeout.stop();
+  mSeekInFlight = false;
+  mPendingSeek.reset();
+  mJumpFrame = QVideoFrame();
+  mSeekStatistics = SeekStatistics();
+  mFrameRing.clear();
+  mShownFrameTime = -1;
+  mSteppedPosition.reset();
+  mLoop.reset();
+  mWrapTimer.stop();
+  mRange = Playlist::range(videoUrl);
+  mRangeEnded = false;
+
+  if (mStandbyLoaded && videoUrl == mStandbyUrl)
+  {
+    swapToStandby();
+    return;
+  }
+  mVideoPlayer->setSource(Playlist::fileUrl(videoUrl)); // the backend gets the file, the range is played by us
+}
+
+void VideoPlayer::prepare(const QUrl& videoUrl)
+{
+  if (videoUrl == mStandbyUrl)
+  {
+    return;
+  }
+  mStandbyUrl = videoUrl;
+  mStandbyLoaded = false;
+  mStandbyPlayer->setSource(Playlist::fileUrl(videoUrl));
+}
+
+void VideoPlayer::swapPlayers()
+{
+  // the outputs move over, a sink is served by one player at a time
+  QMediaPlayer* wOld = mVideoPlayer.get();
+  QMediaPlayer* wNew = mStandbyPlayer.get();
+  wNew->setVideoOutput(nullptr);
+  wOld->setVideoOutput(nullptr);
+  wNew->setVideoOutput(mVideoWidget);
+  wOld->setVideoOutput(mStandbySink);
+  wOld->setAudioOutput(nullptr);
+  wNew->setAudioOutput(mAudioOutput);
+  wNew->setPlaybackRate(wOld->playbackRate());
+
+  std::swap(mVideoPlayer, mStandbyPlayer);
+  wOld->stop(); // on standby already, its signals are not forwarded
+  mStandbyUrl.clear();
+  mStandbyLoaded = false;
+  wOld->setSource(QUrl()); // the file is released, the owner prepares the next entry on it
+  mLastFrameTime = -1;
+}
+
+void VideoPlayer::swapToStandby()
+{
+  swapPlayers();
+  emit durationChanged(getDuration());
+
+  // the media is loaded already, the owner still gets the notification from the event loop like after a cold load
+  const quint64 wSerial = mLoadSerial;
+  QMetaObject::invokeMethod(this, [this, wSerial]() {
+    if (wSerial != mLoadSerial || mIsVideoLoaded)
+    {
+      return;
+    }
+    mIsVideoLoaded = true;
+    emit videoLoaded();
+    }, Qt::QueuedConnection);
+}
+
+void VideoPlayer::setLoop(const std::optional<Sequence>& loop, const bool wrap)
+{
+  mLoop = loop;
+  mLoopWrap = wrap;
+  mRangeEnded = false;
+  mWrapTimer.stop();
+  if (mLoop && mLoopWrap)
+  {
+    prepare(Playlist::rangeUrl(mVideoPlayer->source(), *mLoop));
+  }
+}
+
+void VideoPlayer::wrapLoop()
+{
+  mWrapTimer.stop();
+  if (!mLoop || !isPlaying())
+  {
+    return;
+  }
+
+  const QUrl wLoopUrl = Playlist::rangeUrl(mVideoPlayer->source(), *mLoop);
+  if (mStandbyLoaded && mStandbyUrl == wLoopUrl)
+  {
+    // the start is decoded and waiting, the old player pre-rolls it again for the next round
+    swapPlayers();
+    mSteppedPosition.reset();
+    mVideoPlayer->play();
+    prepare(wLoopUrl);
+  }
+  else
+  {
+    mVideoPlayer->setPosition(mLoop->first.ms()); // the standby is not ready yet, e.g. a loop shorter than its load
+  }
+  mRangeEnded = false;
+}
+
+void VideoPlayer::setKeyframeIndex(const KeyframeIndex* keyframes)
+{
+  mKeyframes = keyframes;
+}
+
+std::optional<Sequence> VideoPlayer::range() const
+{
+  return mRange;
 }
 
 VTime VideoPlayer::getDuration() const
@@ -71,90 +296,462 @@ VTime VideoPlayer::getDuration() const
 
 VTime VideoPlayer::getPosition() const
 {
-  return VTime(mVideoPlayer->position());
+  if (mKeyframeTimer.isActive())
+  {
+    return keyframeClock();
+  }
+  if (mSteppedPosition)
+  {
+    return *mSteppedPosition;
+  }
+  return isSeeking() ? mSeekTarget : VTime(mVideoPlayer->position());
 }
 
 bool VideoPlayer::isPlaying() const
 {
-  return mVideoPlayer->isPlaying();
+  return mKeyframeTimer.isActive() || mVideoPlayer->isPlaying();
 }
 
 void VideoPlayer::play()
 {
+  if (usesKeyframes(mRate))
+  {
+    if (!mKeyframeTimer.isActive() || isPlayingBackward())
+    {
+      startKeyframePlayback(mRate);
+    }
+    return;
+  }
+
+  if (const std::optional<VTime> wPosition = stopKeyframePlayback())
+  {
+    mVideoPlayer->setPosition(wPosition->ms()); // from backward to forward
+  }
+  if (mSteppedPosition)
+  {
+    mVideoPlayer->setPosition(mSteppedPosition->ms()); // the playback goes on from the frame on screen
+    mSteppedPosition.reset();
+  }
   mVideoPlayer->play();
 }
 
 void VideoPlayer::pause()
 {
+  if (const std::optional<VTime> wPosition = stopKeyframePlayback())
+  {
+    requestSeek(*wPosition, true, true); // the exact frame of the clock, not the keyframe before it
+    emit playingChanged(false);
+    return;
+  }
   mVideoPlayer->pause();
 }
 
 void VideoPlayer::stop()
 {
+  stopKeyframePlayback();
   mVideoPlayer->stop();
 }
 
 void VideoPlayer::seekBackward(VTime size)
 {
-  const bool wPlaying = isPlaying();
-  if (mVideoPlayer->position() <= size.ms())
+  // held keys step from the last request, the player may not be there yet
+  const VTime wPosition = getPosition();
+  mSeekStatistics.mInteractive = true;
+  requestSeek(wPosition <= size ? VTime(0) : wPosition - size, true);
+}
+
+void VideoPlayer::seekForward(VTime size)
+{
+  const VTime wPosition = getPosition();
+  mSeekStatistics.mInteractive = true;
+  requestSeek(wPosition + size >= getDuration() ? getDuration() : wPosition + size, true);
+}
+
+void VideoPlayer::scrub(const VTime& position)
+{
+  mSeekStatistics.mInteractive = true;
+  requestSeek(position, true);
+}
+
+float VideoPlayer::volume() const
+{
+  return mAudioOutput->volume();
+}
+
+bool VideoPlayer::isMuted() const
+{
+  return mAudioOutput->isMuted();
+}
+
+QSize VideoPlayer::videoDimensions() const
+{
+  return mVideoPlayer->videoSink()->videoSize();
+}
+
+bool VideoPlayer::hasAudio() const
+{
+  return mVideoPlayer->hasAudio();
+}
+
+void VideoPlayer::stepFrame(const bool forward)
+{
+  if (isPlaying())
   {
-    mVideoPlayer->setPosition(0);
+    pause();
+  }
+
+  if (mShownFrameTime >= 0 && !isSeeking())
+  {
+    const std::optional<QVideoFrame> wFrame = forward ? mFrameRing.next(mShownFrameTime) : mFrameRing.previous(mShownFrameTime);
+    if (wFrame)
+    {
+      present(*wFrame);
+      return;
+    }
+  }
+
+  // not in memory, an exact seek to the boundary decodes it, and it joins the ring when shown
+  const QVideoFrame wShown = currentFrame();
+  const VTime wPosition = getPosition();
+  mSeekStatistics.mInteractive = true;
+  if (!wShown.isValid() || wShown.startTime() < 0 || wShown.endTime() <= wShown.startTime())
+  {
+    requestSeek(forward ? wPosition + VTime(25) : (wPosition > VTime(25) ? wPosition - VTime(25) : VTime(0)), true, true);
     return;
   }
-  mVideoPlayer->setPosition(mVideoPlayer->position() - size.ms());
+  const qint64 wTarget = forward ? (wShown.endTime() + 999) / 1000 : (wShown.startTime() - 1) / 1000;
+  requestSeek(VTime(std::clamp<qint64>(wTarget, 0, getDuration().ms())), true, true);
+}
 
-  if (!wPlaying)
+void VideoPlayer::setFrameRingBudget(const qint64 bytes)
+{
+  mFrameRing.setBudget(bytes);
+}
+
+void VideoPlayer::present(const QVideoFrame& frame)
+{
+  mShowingFrame = true;
+  mVideoWidget->videoSink()->setVideoFrame(frame);
+  mShowingFrame = false;
+
+  mShownFrameTime = frame.startTime();
+  mFrameRing.setCurrent(mShownFrameTime);
+  mSteppedPosition = VTime((mShownFrameTime + 999) / 1000); // inside the frame, a seek there shows the same one
+  emit positionChanged(*mSteppedPosition);
+}
+
+void VideoPlayer::jump(const VTime& position, const QVideoFrame& frame)
+{
+  // the seek goes first, it flushes the frames of the old position, ours stays on screen until the new ones come
+  requestSeek(position, true, true);
+  if (frame.isValid())
   {
-    mVideoPlayer->pause(); // TODO seems working, but check what is the best here?
+    present(frame);
+    mJumpFrame = mSeekInFlight ? frame : QVideoFrame(); // requestSeek dropped the one of an earlier jump
   }
 }
 
-void VideoPlayer::seekForward(VTime size)
+void VideoPlayer::setPosition(VTime position, const bool updateNeeded)
 {
-  const bool wPlaying = isPlaying();
-  if (mVideoPlayer->position() + size.ms() >= mVideoPlayer->duration())
+  requestSeek(position, updateNeeded);
+}
+
+void VideoPlayer::requestSeek(const VTime& position, const bool updateNeeded, const bool exact)
+{
+  if (mKeyframeTimer.isActive())
   {
-    mVideoPlayer->setPosition(mVideoPlayer->duration());
+    anchorKeyframePlayback(position); // the clock goes on from there
+    onKeyframeTick();
     return;
   }
-  mVideoPlayer->setPosition(mVideoPlayer->position() + size.ms());
-  
-  if (!wPlaying)
+
+  const bool wScrubbing = mSettleTimer.isActive();
+  mSteppedPosition.reset();
+  mJumpFrame = QVideoFrame();
+  mSeekTarget = position;
+  mSeekUpdateNeeded = updateNeeded;
+  ++mSeekStatistics.mRequested;
+  mSettleTimer.start();
+
+  if (!wScrubbing || exact || mKeyframes == nullptr || !mKeyframes->isReady(mVideoPlayer->source()))
+  {
+    issueSeek(position); // a single request goes to the exact position right away
+    return;
+  }
+
+  const VTime wKeyframe = mKeyframes->nearest(position);
+  if (wKeyframe == (mPendingSeek ? *mPendingSeek : mIssuedPosition))
+  {
+    return; // that picture is on its way already
+  }
+  ++mSeekStatistics.mKeyframeSeeks;
+  issueSeek(wKeyframe);
+}
+
+void VideoPlayer::issueSeek(const VTime& position)
+{
+  if (mSeekInFlight)
+  {
+    mPendingSeek = position; // the decoder would only be busy with a position nobody waits for anymore
+    return;
+  }
+
+  mSeekInFlight = true;
+  mIssuedPosition = position;
+  mSeekIssuedClock = mFrameClock.nsecsElapsed() / 1000;
+  ++mSeekStatistics.mIssued;
+  mSeekTimeout.start();
+
+  const bool wPlaying = isPlaying();
+  mVideoPlayer->setPosition(position.ms());
+  if (mSeekUpdateNeeded && !wPlaying)
   {
     mVideoPlayer->pause(); // TODO seems working, but check what is the best here?
   }
 }
 
-float VideoPlayer::volume() const
+bool VideoPlayer::isSeekPicture(const QVideoFrame& frame) const
 {
-  return mAudioOutput->volume();
+  if (frame.startTime() < 0)
+  {
+    return true; // no timestamps to tell
+  }
+  // the backend lands on the frame holding the position, a frame further away was decoded before the seek
+  const qint64 wDuration = frame.endTime() > frame.startTime() ? frame.endTime() - frame.startTime() : 0;
+  const qint64 wTolerance = std::max<qint64>(wDuration, 40000);
+  const qint64 wIssued = mIssuedPosition.ms() * 1000;
+  return frame.startTime() - wTolerance <= wIssued && wIssued <= frame.startTime() + wDuration + wTolerance;
 }
 
-bool VideoPlayer::isMuted() const
+void VideoPlayer::onSeekDisplayed()
 {
-  return mAudioOutput->isMuted();
+  if (!mSeekInFlight)
+  {
+    return;
+  }
+
+  const VTime wLatency((mFrameClock.nsecsElapsed() / 1000 - mSeekIssuedClock) / 1000);
+  mSeekStatistics.mLatency = wLatency;
+  mSeekStatistics.mMaxLatency = std::max(mSeekStatistics.mMaxLatency, wLatency);
+  finishSeek();
 }
 
-QSize VideoPlayer::videoDimensions() const
+void VideoPlayer::onSeekTimeout()
 {
-  return mVideoPlayer->videoSink()->videoSize();
+  if (!mSeekInFlight)
+  {
+    return;
+  }
+  ++mSeekStatistics.mTimeouts;
+  finishSeek();
 }
 
-void VideoPlayer::setPosition(VTime position, const bool updateNeeded)
+void VideoPlayer::finishSeek()
 {
-  const bool wPlaying = isPlaying();
-  mVideoPlayer->setPosition(position.ms());
+  mSeekInFlight = false;
+  mSeekTimeout.stop();
 
-  if (updateNeeded && !wPlaying)
+  if (mPendingSeek)
   {
-    mVideoPlayer->pause(); // TODO seems working, but check what is the best here?
+    const VTime wPosition = *mPendingSeek;
+    mPendingSeek.reset();
+    issueSeek(wPosition);
+    return;
+  }
+  mJumpFrame = QVideoFrame();
+  if (!mSettleTimer.isActive() && !mKeyframeTimer.isActive() && mIssuedPosition == mSeekTarget)
+  {
+    emit seekStatistics(mSeekStatistics);
+    mSeekStatistics = SeekStatistics();
   }
 }
 
+void VideoPlayer::onSeekSettled()
+{
+  // the input stopped, the exact position replaces the keyframe shown for it
+  if ((mPendingSeek ? *mPendingSeek : mIssuedPosition) != mSeekTarget)
+  {
+    issueSeek(mSeekTarget);
+  }
+  else if (!mSeekInFlight)
+  {
+    emit seekStatistics(mSeekStatistics);
+    mSeekStatistics = SeekStatistics();
+  }
+}
+
+bool VideoPlayer::isSeeking() const
+{
+  return mSeekInFlight || mSettleTimer.isActive();
+}
+
+qreal VideoPlayer::playbackRate() const
+{
+  return mRate;
+}
+
 void VideoPlayer::setPlaybackRate(qreal rate)
 {
+  const VTime wClock = keyframeClock();
+  mRate = rate;
   mVideoPlayer->setPlaybackRate(rate);
+
+  if (!mKeyframeTimer.isActive())
+  {
+    if (mVideoPlayer->isPlaying() && usesKeyframes(rate))
+    {
+      startKeyframePlayback(rate);
+    }
+    return;
+  }
+  if (isPlayingBackward() || usesKeyframes(rate))
+  {
+    anchorKeyframePlayback(wClock); // the new rate counts from here
+    return;
+  }
+  // slow enough for the full decode again
+  stopKeyframePlayback();
+  mVideoPlayer->setPosition(wClock.ms());
+  mVideoPlayer->play();
+}
+
+void VideoPlayer::setKeyframeRate(const qreal rate)
+{
+  mKeyframeRate = std::max<qreal>(1.0, rate);
+  if (isPlaying())
+  {
+    setPlaybackRate(mRate); // the strategy may change
+  }
+}
+
+void VideoPlayer::playBackward(const qreal rate)
+{
+  mRate = rate;
+  mVideoPlayer->setPlaybackRate(rate);
+  startKeyframePlayback(-rate);
+}
+
+bool VideoPlayer::isPlayingBackward() const
+{
+  return mKeyframeTimer.isActive() && mKeyframeDirection < 0.0;
+}
+
+DecodeStrategy VideoPlayer::decodeStrategy() const
+{
+  return mKeyframeTimer.isActive() ? DecodeStrategy::Keyframes : DecodeStrategy::Full;
+}
+
+bool VideoPlayer::usesKeyframes(const qreal rate) const
+{
+  return rate > mKeyframeRate || (mFallBehindRate > 0.0 && rate >= mFallBehindRate);
+}
+
+void VideoPlayer::startKeyframePlayback(const qreal rate)
+{
+  const bool wWasPlaying = isPlaying();
+  anchorKeyframePlayback(getPosition());
+  mKeyframeDirection = rate < 0.0 ? -1.0 : 1.0;
+  mSteppedPosition.reset();
+  mWrapTimer.stop();
+  mSettleTimer.stop();
+  mLastFrameTime = -1;
+  mStatistics = PlaybackStatistics();
+
+  // the decoder only gets the seeks, the timer keeps isPlaying true through the pause
+  mKeyframeTimer.start();
+  mVideoPlayer->pause();
+  if (!wWasPlaying)
+  {
+    emit playingChanged(true);
+  }
+  onKeyframeTick();
+}
+
+std::optional<VTime> VideoPlayer::stopKeyframePlayback()
+{
+  if (!mKeyframeTimer.isActive())
+  {
+    return std::nullopt;
+  }
+  const VTime wPosition = keyframeClock();
+  mKeyframeTimer.stop();
+  mSeekStatistics = SeekStatistics();
+  mLastFrameTime = -1;
+  return wPosition;
+}
+
+void VideoPlayer::anchorKeyframePlayback(const VTime& position)
+{
+  mKeyframeAnchor = position;
+  mKeyframeAnchorClock = mFrameClock.nsecsElapsed() / 1000;
+}
+
+VTime VideoPlayer::keyframeClock() const
+{
+  const qint64 wOffset = std::llround((mFrameClock.nsecsElapsed() / 1000 - mKeyframeAnchorClock) / 1000.0 * mRate);
+  if (mKeyframeDirection < 0.0)
+  {
+    return mKeyframeAnchor.ms() > wOffset ? mKeyframeAnchor - VTime(wOffset) : VTime(0);
+  }
+  return mKeyframeAnchor + VTime(wOffset);
+}
+
+void VideoPlayer::onKeyframeTick()
+{
+  const std::optional<Sequence> wBounds = mLoop ? mLoop : mRange;
+  const VTime wBegin = wBounds ? wBounds->first : VTime(0);
+  const VTime wEnd = wBounds ? wBounds->second : getDuration();
+  VTime wTarget = keyframeClock();
+
+  if (mKeyframeDirection > 0.0 && wTarget >= wEnd && wEnd > VTime(0))
+  {
+    if (!mLoop)
+    {
+      stopKeyframePlayback();
+      emit playingChanged(false);
+      emit videoEnded();
+      return;
+    }
+    if (!mLoopWrap)
+    {
+      // paused at the end like the full decode, e.g. for the way back of a ping-pong loop
+      stopKeyframePlayback();
+      requestSeek(wEnd, true, true);
+      emit playingChanged(false);
+      emit loopEnded();
+      return;
+    }
+    anchorKeyframePlayback(mLoop->first);
+    wTarget = mLoop->first;
+  }
+  else if (mKeyframeDirection < 0.0 && wTarget <= wBegin)
+  {
+    stopKeyframePlayback();
+    requestSeek(wBegin, true, true);
+    emit playingChanged(false);
+    emit beginReached();
+    return;
+  }
+
+  emit positionChanged(wTarget);
+
+  // without the index every tick is an exact seek, slower, but the one in flight still limits the load
+  VTime wKeyframe = wTarget;
+  if (mKeyframes != nullptr && mKeyframes->isReady(mVideoPlayer->source()))
+  {
+    wKeyframe = std::clamp(mKeyframes->nearest(wTarget), wBegin, std::max(wBegin, wEnd));
+  }
+  if (wKeyframe == (mPendingSeek ? *mPendingSeek : mIssuedPosition))
+  {
+    return;
+  }
+  if (mPendingSeek)
+  {
+    ++mStatistics.mDroppedFrames; // the clock moved past it before the decoder got to it
+  }
+  mSeekTarget = wKeyframe;
+  mSeekUpdateNeeded = true;
+  issueSeek(wKeyframe);
 }
 
 void VideoPlayer::setVolume(float volume)
@@ -171,3 +768,90 @@ QMediaMetaData VideoPlayer::getMetadata() const
 {
   return mVideoPlayer->metaData();
 }
+
+QVideoFrame VideoPlayer::currentFrame() const
+{
+  return mVideoPlayer->videoSink()->videoFrame();
+}
+
+void VideoPlayer::onVideoFrame(const QVideoFrame& frame)
+{
+  if (mShowingFrame)
+  {
+    return;
+  }
+  if (frame.isValid() && mSeekInFlight)
+  {
+    if (isSeekPicture(frame))
+    {
+      onSeekDisplayed();
+    }
+    if (mJumpFrame.isValid() && mSeekInFlight)
+    {
+      present(mJumpFrame); // the old position is not shown over the frame decoded ahead
+      return;
+    }
+  }
+  if (frame.isValid())
+  {
+    mFrameRing.insert(frame, isPlaying());
+    mShownFrameTime = frame.startTime();
+    mSteppedPosition.reset();
+  }
+
+  if (!frame.isValid() || !isPlaying())
+  {
+    mLastFrameTime = -1;
+    return;
+  }
+
+  const qint64 wClock = mFrameClock.nsecsElapsed() / 1000;
+  const qint64 wFrameTime = frame.startTime();
+  if (mKeyframeTimer.isActive())
+  {
+    // the timestamps jump from keyframe to keyframe, the ticks count the ones the decoder was too slow for
+    if (mLastFrameTime < 0)
+    {
+      mWindowStart = wClock;
+    }
+  }
+  else if (mLastFrameTime >= 0 && wFrameTime > mLastFrameTime)
+  {
+    const double wFps = frame.surfaceFormat().frameRate();
+    const double wFrameDuration = wFps > 0.0 ? 1000000.0 / wFps : static_cast<double>(frame.endTime() - wFrameTime);
+    const qint64 wMediaDelta = wFrameTime - mLastFrameTime;
+    if (wFrameDuration > 0.0 && wMediaDelta < 1000000) // a bigger jump is a seek
+    {
+      // the sink only gets the frames actually shown, a skipped frame leaves a gap in the timestamps
+      mStatistics.mDroppedFrames += static_cast<unsigned>(std::max(0L, std::lround(wMediaDelta / wFrameDuration) - 1));
+
+      const qint64 wExpected = static_cast<qint64>(wMediaDelta / std::max(0.01, mVideoPlayer->playbackRate()));
+      mStatistics.mMaxLateness = std::max(mStatistics.mMaxLateness, VTime(std::max<qint64>(0, wClock - mLastFrameClock - wExpected) / 1000));
+    }
+  }
+  else if (mLastFrameTime < 0)
+  {
+    mWindowStart = wClock;
+  }
+
+  ++mStatistics.mPresentedFrames;
+  mLastFrameTime = wFrameTime;
+  mLastFrameClock = wClock;
+
+  if (wClock - mWindowStart >= 1000000)
+  {
+    mStatistics.mStrategy = decodeStrategy();
+    mStatistics.mRate = isPlayingBackward() ? -mRate : mRate;
+    const PlaybackStatistics wStatistics = mStatistics;
+    emit playbackStatistics(wStatistics);
+    mStatistics = PlaybackStatistics();
+    mWindowStart = wClock;
+
+    // more than half of the frames skipped, the full decode does not keep up with this rate on this video
+    if (wStatistics.mStrategy == DecodeStrategy::Full && mRate > 1.0 && wStatistics.mDroppedFrames > wStatistics.mPresentedFrames)
+    {
+      mFallBehindRate = mFallBehindRate > 0.0 ? std::min(mFallBehindRate, mRate) : mRate;
+      startKeyframePlayback(mRate);
+    }
+  }
+}
@@ -1,18 +1,25 @@
 #pragma once
 
 #include "Types.h"
+#include "FrameRing.h"
 
 #include <QObject>
 #include <QMediaMetaData>
+#include <QVideoFrame>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QUrl>
 
 #include <vector>
 #include <memory>
+#include <optional>
 
 class VideoWidget;
 class View;
 class QMediaPlayer;
 class QAudioOutput;
-class QUrl;
+class QVideoSink;
+class KeyframeIndex;
 
 class VideoPlayer : public QObject
 {
@@ -21,10 +28,13 @@ class VideoPlayer : public QObject
 public:
   explicit VideoPlayer(VideoWidget* videoWidget, QObject* parent = nullptr);
 
-  void setVideo(const QUrl& videoUrl);
+  void setVideo(const QUrl& videoUrl); // a file or a range entry of the playlist
+  void setKeyframeIndex(const KeyframeIndex* keyframes); // used for the file it was loaded for, see requestSeek
+  void prepare(const QUrl& videoUrl);  // opened on the standby pipeline, setVideo swaps to it instead of a cold load, empty url releases it
+  std::optional<Sequence> range() const; // of a range entry
 
   VTime getDuration() const;
-  VTime getPosition() const;
+  VTime getPosition() const; // the target of a seek still on its way, or the frame stepped to
 
   bool isPlaying() const;
 
@@ -34,12 +44,38 @@ public:
 
   void seekBackward(VTime size);
   void seekForward(VTime size);
+  void scrub(const VTime& position); // from the slider, like the seek steps its statistics are marked interactive
+
+  // pauses on the next or previous frame, from memory when the ring holds it, see FrameRing
+  void stepFrame(const bool forward);
+  void setFrameRingBudget(const qint64 bytes);
+
+  // shows a frame not coming from the player, e.g. from the ring or the reverse playback
+  // the player stays where it is, getPosition reports the frame and play continues from it
+  void present(const QVideoFrame& frame);
+  qreal playbackRate() const;
+
+  // an exact seek with the frame of the position decoded ahead, it is shown until the player gets there, see SeekTargets
+  void jump(const VTime& position, const QVideoFrame& frame);
+
+  // above the keyframe rate, or where the full decode fell behind at a lower one, only the keyframes nearest to the
+  // clock are shown, they come from seeks while the player is paused: the picture moves smoothly and stays on time
+  void setKeyframeRate(const qreal rate);
+  void playBackward(const qreal rate); // keyframes only at any rate, pause, play or stop ends it
+  bool isPlayingBackward() const;
+  DecodeStrategy decodeStrategy() const;
+
+  // the range plays over and over: its start is pre-rolled on the standby pipeline and swapped in at the end, without a seek
+  // without wrap the player pauses at the end and emits loopEnded, e.g. to play it backward, an empty range stops the loop
+  void setLoop(const std::optional<Sequence>& loop, const bool wrap = true);
 
   float volume() const;
   bool isMuted() const;
   QSize videoDimensions() const;
+  bool hasAudio() const;
 
   QMediaMetaData getMetadata() const;
+  QVideoFrame currentFrame() const; // the frame on screen, as rendered to the sink
 
 public slots:
   void setPosition(VTime position, const bool updateNeeded = false);
@@ -51,12 +87,92 @@ signals:
   void positionChanged(VTime position);
   void durationChanged(VTime duration);
   void videoEnded();
+  void loopEnded();
+  void beginReached(); // of the video or the range, playing backward
   void videoLoaded();
+  void playingChanged(bool playing);
+  void playbackStatistics(const PlaybackStatistics& statistics);
+  void seekStatistics(const SeekStatistics& statistics);
 
 private:
+  void connectPlayer(QMediaPlayer* player);
+  void swapPlayers();
+  void swapToStandby(); // as if the prepared video was loaded
+  void wrapLoop();
+  void onVideoFrame(const QVideoFrame& frame);
+
+  // keyframe playback, the rate is negative backward
+  bool usesKeyframes(const qreal rate) const;
+  void startKeyframePlayback(const qreal rate);
+  std::optional<VTime> stopKeyframePlayback(); // where the clock stopped, nothing if it was not running, the player stays paused
+  void anchorKeyframePlayback(const VTime& position);
+  VTime keyframeClock() const;
+  void onKeyframeTick();
+
+  // seek controller: one seek is in flight at a time, a newer request replaces the one waiting behind it
+  // while the requests keep coming the nearest keyframe is shown, it decodes in one step, the exact position follows when they stop
+  void requestSeek(const VTime& position, const bool updateNeeded, const bool exact = false); // exact: never a keyframe
+  void issueSeek(const VTime& position);
+  bool isSeekPicture(const QVideoFrame& frame) const; // around the issued position, not a frame queued before the seek
+  void onSeekDisplayed();
+  void onSeekTimeout();
+  void finishSeek();
+  void onSeekSettled();
+  bool isSeeking() const;
+
+  VideoWidget* mVideoWidget = nullptr;
   std::unique_ptr<QMediaPlayer> mVideoPlayer;
+  std::unique_ptr<QMediaPlayer> mStandbyPlayer; // the signals of a player are handled only while it is the active one
+  QVideoSink* mStandbySink = nullptr;           // the standby decodes its first frame into this, off screen
+  QUrl mStandbyUrl;
+  bool mStandbyLoaded = false;
+  quint64 mLoadSerial = 0; // a queued videoLoaded of a swap is dropped if another video was set since
   std::unique_ptr<QMediaPlayer> mMusicPlayer;
   bool mIsVideoLoaded = false;
+  std::optional<Sequence> mRange;
+  bool mRangeEnded = false; // videoEnded is emitted once, until the position is back in the range
+  std::optional<Sequence> mLoop; // ends instead of the range while set
+  bool mLoopWrap = true;
+  QTimer mWrapTimer;        // the wrap is scheduled from the last position updates, they come too rarely to hit the end
 
   QAudioOutput* mAudioOutput = nullptr;
+
+  // frame stepping
+  FrameRing mFrameRing;
+  qint64 mShownFrameTime = -1;          // start time of the frame on screen (us)
+  std::optional<VTime> mSteppedPosition; // where the ring took the picture, the player is elsewhere
+  bool mShowingFrame = false;           // our own frame coming back from the sink
+
+  const KeyframeIndex* mKeyframes = nullptr;
+  QTimer mSettleTimer;        // runs while the seek requests keep coming
+  QTimer mSeekTimeout;        // a seek never shown, e.g. no video stream, does not block the next ones
+  VTime mSeekTarget;          // the last request
+  bool mSeekUpdateNeeded = false;
+  bool mSeekInFlight = false;
+  VTime mIssuedPosition;
+  qint64 mSeekIssuedClock = 0; // us
+  std::optional<VTime> mPendingSeek;
+  QVideoFrame mJumpFrame;     // decoded ahead by the owner, it stays on screen until the seek of jump is displayed
+  SeekStatistics mSeekStatistics;
+
+  // keyframe playback
+  qreal mRate = 1.0;                     // asked for, the player runs at it with the full decode
+  qreal mKeyframeRate = 3.0;
+  qreal mFallBehindRate = 0.0;           // where the full decode of this video was too slow, 0 until it happens
+  QTimer mKeyframeTimer;
+  qreal mKeyframeDirection = 1.0;
+  VTime mKeyframeAnchor;
+  qint64 mKeyframeAnchorClock = 0;       // us
+
+  static constexpr int sKeyframeTickMs = 40;
+  static constexpr int sWrapLeadMs = 200;
+  static constexpr int sSettleMs = 150;
+  static constexpr int sSeekTimeoutMs = 1000;
+
+  // playback statistics
+  QElapsedTimer mFrameClock;
+  qint64 mLastFrameTime = -1;  // presentation time of the previous frame (us)
+  qint64 mLastFrameClock = 0;  // wall clock when it was presented (us)
+  qint64 mWindowStart = 0;
+  PlaybackStatistics mStatistics;
 };
@@ -19,6 +19,12 @@ void VideoWidget::mousePressEvent(QMouseEvent* event)
   QVideoWidget::mousePressEvent(event);
 }
 
+void VideoWidget::enterEvent(QEnterEvent* event)
+{
+  emit mouseEntered();
+  QVideoWidget::enterEvent(event);
+}
+
 void VideoWidget::dragEnterEvent(QDragEnterEvent* event)
 {
   if (event->mimeData()->hasUrls())
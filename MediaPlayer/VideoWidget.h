@@ -14,10 +14,12 @@ public:
 
 signals:
   void mouseClicked();
+  void mouseEntered();
   void filesDropped(const QList<QUrl>& urls);
 
 protected:
   virtual void mousePressEvent(QMouseEvent* event) override;
+  virtual void enterEvent(QEnterEvent* event) override;
   virtual void dragEnterEvent(QDragEnterEvent* event) override;
   //virtual void dragMoveEvent(QDragMoveEvent *event) override;
   //virtual void dragLeaveEvent(QDragLeaveEvent *event) override;
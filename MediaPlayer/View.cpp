@@ -2,9 +2,11 @@
 #include "VideoWidget.h"
 #include "Slider.h"
 #include "CursorHider.h"
+#include "Playlist.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QGridLayout>
 #include <QPushButton>
 #include <QLabel>
 #include <QTime>
@@ -22,6 +24,9 @@
 #include <QFileInfo>
 #include <QLineEdit>
 #include <QStyle>
+#include <QSignalBlocker>
+
+#include <cmath>
 
 View::View(QWidget* parent)
   : QWidget(parent)
@@ -142,7 +147,7 @@ View::View(QWidget* parent)
 
   mSpeedSpinBox = new QDoubleSpinBox(this);
   mSpeedSpinBox->setObjectName("speedSpinBox");
-  mSpeedSpinBox->setRange(0.1, 10.0);
+  mSpeedSpinBox->setRange(0.1, 32.0);
   mSpeedSpinBox->setValue(1.0);
   mSpeedSpinBox->setSingleStep(0.05);
   mSpeedSpinBox->setPrefix("Speed: ");
@@ -151,6 +156,18 @@ View::View(QWidget* parent)
   mSpeedSpinBox->setMinimumWidth(130);
   mSpeedSpinBox->setFocusPolicy(Qt::NoFocus);
 
+  mHealthLabel = new QLabel(this);
+  mHealthLabel->setObjectName("healthLabel");
+  mHealthLabel->setAlignment(Qt::AlignCenter | Qt::AlignVCenter);
+  mHealthLabel->setMinimumWidth(150);
+  mHealthLabel->setFocusPolicy(Qt::NoFocus);
+
+  mSeekLabel = new QLabel(this);
+  mSeekLabel->setObjectName("seekLabel");
+  mSeekLabel->setAlignment(Qt::AlignCenter | Qt::AlignVCenter);
+  mSeekLabel->setMinimumWidth(90);
+  mSeekLabel->setFocusPolicy(Qt::NoFocus);
+
   mVolumeSpinBox = new QDoubleSpinBox(this);
   mVolumeSpinBox->setObjectName("volumeSpinBox");
   mVolumeSpinBox->setRange(0.0, 1.0);
@@ -179,6 +196,8 @@ View::View(QWidget* parent)
   mButtonLayout->addWidget(mPositionLabel);
   mButtonLayout->addWidget(mDurationLabel);
   mButtonLayout->addWidget(mSpeedSpinBox);
+  mButtonLayout->addWidget(mHealthLabel);
+  mButtonLayout->addWidget(mSeekLabel);
   mButtonLayout->addWidget(mLoopCountSpinBox);
   mButtonLayout->addWidget(mBurstLengthSpinBox);
   mButtonLayout->addWidget(mAudioButton);
@@ -197,7 +216,14 @@ View::View(QWidget* parent)
   QHBoxLayout* videoLayout = new QHBoxLayout;
   videoLayout->setContentsMargins(0,0,0,0);
   videoLayout->setSpacing(0);
+  mGridWidget = new QWidget(this);
+  mGridLayout = new QGridLayout(mGridWidget);
+  mGridLayout->setContentsMargins(0,0,0,0);
+  mGridLayout->setSpacing(2);
+  mGridWidget->hide();
+
   videoLayout->addWidget(mVideoWidget, 1);
+  videoLayout->addWidget(mGridWidget, 1);
   videoLayout->addWidget(mSidePanel, 0);
 
   mControlsPanel = new QWidget(this);
@@ -275,6 +301,42 @@ VideoWidget* View::getVideoWidget() const
   return mVideoWidget;
 }
 
+std::vector<QVideoSink*> View::showGrid(const std::size_t count)
+{
+  hideGrid();
+
+  const int wColumns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+  std::vector<QVideoSink*> wSinks;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    VideoWidget* wTile = new VideoWidget(mGridWidget);
+    wTile->setFocusPolicy(Qt::NoFocus);
+    wTile->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    mGridLayout->addWidget(wTile, static_cast<int>(i) / wColumns, static_cast<int>(i) % wColumns);
+    connect(wTile, &VideoWidget::mouseEntered, this, [this, i]() { emit tileHovered(i); });
+    connect(wTile, &VideoWidget::mouseClicked, this, [this, i]() { emit tileClicked(i); });
+    mTiles.push_back(wTile);
+    wSinks.push_back(wTile->videoSink());
+  }
+
+  mVideoWidget->hide();
+  mGridWidget->show();
+  return wSinks;
+}
+
+void View::hideGrid()
+{
+  // a click on a tile closes the grid, the tile is still in its event handler
+  for (VideoWidget* wTile : mTiles)
+  {
+    wTile->hide();
+    wTile->deleteLater();
+  }
+  mTiles.clear();
+  mGridWidget->hide();
+  mVideoWidget->show();
+}
+
 QLayout* View::getLayout() const
 {
   return mLayout;
@@ -321,6 +383,58 @@ void View::setVolume(float volume)
   mVolumeSpinBox->setValue(static_cast<double>(volume));
 }
 
+void View::setSpeed(double speed)
+{
+  const QSignalBlocker wBlocker(mSpeedSpinBox);
+  mSpeedSpinBox->setValue(speed);
+}
+
+void View::setPlaybackHealth(const std::optional<PlaybackStatistics>& statistics)
+{
+  if (!statistics)
+  {
+    mHealthLabel->clear();
+    return;
+  }
+
+  QString wStrategy;
+  switch (statistics->mStrategy)
+  {
+    case DecodeStrategy::Full:
+      wStrategy = "Full";
+      break;
+    case DecodeStrategy::Keyframes:
+      wStrategy = "Keyframes";
+      break;
+    case DecodeStrategy::Reverse:
+      wStrategy = "Reverse";
+      break;
+  }
+  QString wText = QString("%1 %2x").arg(wStrategy).arg(statistics->mRate, 0, 'g', 3);
+  if (statistics->mPresentedFrames > 0)
+  {
+    wText += QString(" %1 fps").arg(statistics->mPresentedFrames);
+  }
+  mHealthLabel->setText(wText);
+
+  // the frames the strategy could not deliver, a keyframe strategy is healthy as long as it keeps up with its clock
+  const bool wHealthy = statistics->mDroppedFrames <= 1 && statistics->mMaxLateness.ms() <= 40;
+  mHealthLabel->setStyleSheet(wHealthy ? "QLabel { color: #50B450; }" : "QLabel { color: #D08030; }");
+}
+
+void View::setSeekStatistics(const SeekStatistics& statistics)
+{
+  QString wText = QString("Seek: %1 ms").arg(statistics.mLatency.ms());
+  if (statistics.mTimeouts > 0)
+  {
+    wText += QString(", %1 lost").arg(statistics.mTimeouts);
+  }
+  mSeekLabel->setText(wText);
+  mSeekLabel->setToolTip(QString("%1 ms to the final picture, at most %2 ms\n%3 of %4 requests issued, %5 on keyframes, %6 never shown")
+                         .arg(statistics.mLatency.ms()).arg(statistics.mMaxLatency.ms()).arg(statistics.mIssued).arg(statistics.mRequested)
+                         .arg(statistics.mKeyframeSeeks).arg(statistics.mTimeouts));
+}
+
 void View::setRandomize(const bool isRandomized)
 {
   mRandomizeCheckBox->setChecked(isRandomized);
@@ -396,7 +510,11 @@ void View::setVideoList(const std::vector<QUrl>& videos)
   mVideoList->clear();
   for (const auto& video : videos)
   {
-    const QString displayName = QFileInfo(video.toLocalFile()).completeBaseName();
+    QString displayName = QFileInfo(video.toLocalFile()).completeBaseName();
+    if (const std::optional<Sequence> range = Playlist::range(video))
+    {
+      displayName += QString(" [%1 - %2]").arg(range->first.toString(), range->second.toString());
+    }
 
     QListWidgetItem* item = new QListWidgetItem(displayName);
     item->setData(Qt::UserRole, QVariant::fromValue(video));
@@ -6,6 +6,8 @@
 #include <QWidget>
 #include <QUrl>
 
+#include <optional>
+
 class VideoWidget;
 class VideoPlayer;
 class Slider;
@@ -22,6 +24,8 @@ class QCheckBox;
 class QListWidget;
 class QHBoxLayout;
 class QLineEdit;
+class QGridLayout;
+class QVideoSink;
 
 class View : public QWidget
 {
@@ -38,6 +42,9 @@ public:
   void setMarking(bool marking);
   void setCursorTimeout(int timeoutMs);
   void setVolume(float volume);
+  void setSpeed(double speed); // without speedChanged, e.g. for the shuttle
+  void setPlaybackHealth(const std::optional<PlaybackStatistics>& statistics); // the decode strategy and its frame rate, empty while stopped
+  void setSeekStatistics(const SeekStatistics& statistics); // of the last seek of the user, the details are in the tooltip
   void setRandomize(bool state);
   unsigned getLoopCount() const;
   VTime getBurstLength() const;
@@ -47,6 +54,10 @@ public:
   void setVideoList(const std::vector<QUrl>& videos);
   void setSequences(const SequenceMap& seqences);
 
+  // the multi-view: count tiles in place of the video widget, the sinks are for the decoders of the tiles
+  std::vector<QVideoSink*> showGrid(const std::size_t count);
+  void hideGrid();
+
   void focusPlayButton();
   void focusFilterEdit();
 
@@ -81,6 +92,8 @@ signals:
 
   void onMouseClick();
   void onMouseDoubleClick();
+  void tileHovered(std::size_t index);
+  void tileClicked(std::size_t index);
 
 private:
   std::map<QString, QPixmap> mPixmapTable;
@@ -106,6 +119,8 @@ private:
   QSpinBox* mLoopCountSpinBox;
   QDoubleSpinBox* mBurstLengthSpinBox;
   QDoubleSpinBox* mSpeedSpinBox;
+  QLabel* mHealthLabel;
+  QLabel* mSeekLabel;
   QDoubleSpinBox* mVolumeSpinBox;
 
   QPlainTextEdit* mInfoBar;
@@ -114,6 +129,9 @@ private:
   bool mIsFullscreenView = false;
 
   QWidget* mSidePanel = nullptr;
+  QWidget* mGridWidget = nullptr;
+  QGridLayout* mGridLayout = nullptr;
+  std::vector<VideoWidget*> mTiles;
   QWidget* mControlsPanel = nullptr;
 
   std::unique_ptr<CursorHider> mCursorHider;
@@ -1,5 +1,6 @@
 #include "MainWindow.h"
 #include "MediaPlayer.h"
+#include "JobDaemon.h"
 
 #include <QtWidgets/QApplication>
 #include <QSettings>
@@ -19,9 +20,15 @@ void loadPreferences(MainWindow& iMainWindow);
 Playlist readPlaylistFile(const QString& iFilePath);
 Playlist readDirectory(const QString& iDirectoryPath);
 QString readStyles(const QString& iFilePath);
+int runJobDaemon(int argc, char* argv[]);
 
 int main(int argc, char* argv[])
 {
+  if (argc > 1 && QString(argv[1]) == "--job-daemon")
+  {
+    return runJobDaemon(argc, argv);
+  }
+
   QApplication wApp(argc, argv);
   int wExitStatus = -1;
 
@@ -87,6 +94,21 @@ int main(int argc, char* argv[])
 
 ////////////////
 // Implementation of helper functions
+int runJobDaemon(int argc, char* argv[])
+{
+  // no window, it outlives the players that started it
+  QCoreApplication wApp(argc, argv);
+  wApp.setOrganizationName("IstuSoft");
+  wApp.setApplicationName("MediaPlayer");
+
+  JobDaemon wDaemon;
+  if (!wDaemon.start())
+  {
+    return 0; // an other one is serving already
+  }
+  return wApp.exec();
+}
+
 void savePreferences(const MainWindow& iMainWindow)
 {
   const auto& wPlacement = iMainWindow.getPlacement();
@@ -100,6 +122,53 @@ void savePreferences(const MainWindow& iMainWindow)
   settings.setValue("cursorTimeout", iMainWindow.getSettings().mCursorTimeout);
   settings.setValue("volume", iMainWindow.getSettings().mVolume);
   settings.setValue("randomize", iMainWindow.getSettings().mRandomize);
+
+  QStringList wRenditions;
+  for (const int wHeight : iMainWindow.getSettings().mRenditionHeights)
+  {
+    wRenditions.push_back(QString::number(wHeight));
+  }
+  settings.setValue("renditions", wRenditions.join(','));
+  settings.setValue("crop", iMainWindow.getSettings().mCrop);
+  settings.setValue("outputHeight", iMainWindow.getSettings().mOutputHeight);
+  settings.setValue("outputFps", iMainWindow.getSettings().mOutputFps);
+  settings.setValue("outputSpeed", iMainWindow.getSettings().mOutputSpeed);
+  settings.setValue("normalizeAudio", iMainWindow.getSettings().mNormalizeAudio);
+  settings.setValue("timeLapseSpeed", iMainWindow.getSettings().mTimeLapseSpeed);
+  settings.setValue("timeLapseKeyframeStep", iMainWindow.getSettings().mTimeLapseKeyframeStep);
+  settings.setValue("timeLapseFps", iMainWindow.getSettings().mTimeLapseFps);
+  settings.setValue("animationFormat", static_cast<quint32>(iMainWindow.getSettings().mAnimationFormat));
+  settings.setValue("animationWidth", iMainWindow.getSettings().mAnimationWidth);
+  settings.setValue("animationFps", iMainWindow.getSettings().mAnimationFps);
+  settings.setValue("targetSizeMB", iMainWindow.getSettings().mTargetSizeMB);
+  settings.setValue("fragmentedOutput", iMainWindow.getSettings().mFragmentedOutput);
+  settings.setValue("speculativeCut", iMainWindow.getSettings().mSpeculativeCut);
+  settings.setValue("chapterRemux", iMainWindow.getSettings().mChapterRemux);
+  settings.setValue("prewarmNext", iMainWindow.getSettings().mPrewarmNext);
+  settings.setValue("frameRingMB", iMainWindow.getSettings().mFrameRingMB);
+  settings.setValue("reverseMaxHeight", iMainWindow.getSettings().mReverseMaxHeight);
+  settings.setValue("keyframeRate", iMainWindow.getSettings().mKeyframeRate);
+  settings.setValue("predecodeSeeks", iMainWindow.getSettings().mPredecodeSeeks);
+  settings.setValue("gridDecodeBudget", iMainWindow.getSettings().mGridDecodeBudget);
+  settings.setValue("gridTileHeight", iMainWindow.getSettings().mGridTileHeight);
+  settings.setValue("prefetchCount", iMainWindow.getSettings().mPrefetchCount);
+  settings.setValue("prefetchHeadMB", iMainWindow.getSettings().mPrefetchHeadMB);
+  settings.setValue("prefetchBudgetMB", iMainWindow.getSettings().mPrefetchBudgetMB);
+  settings.setValue("imageFormat", static_cast<quint32>(iMainWindow.getSettings().mImageFormat));
+  settings.setValue("frameStep", iMainWindow.getSettings().mFrameStep);
+  settings.setValue("batchTemplate", static_cast<quint32>(iMainWindow.getSettings().mBatchTemplate));
+  settings.setValue("batchLength", iMainWindow.getSettings().mBatchLength);
+  settings.setValue("maxJobs", iMainWindow.getSettings().mMaxJobs);
+  settings.setValue("readersPerDevice", iMainWindow.getSettings().mReadersPerDevice);
+  settings.setValue("writersPerDevice", iMainWindow.getSettings().mWritersPerDevice);
+  settings.setValue("threadBudget", iMainWindow.getSettings().mThreadBudget);
+
+  QStringList wDeviceLimits;
+  for (const auto& wLimit : iMainWindow.getSettings().mDeviceReaderLimits)
+  {
+    wDeviceLimits.push_back(wLimit.first + ":" + QString::number(wLimit.second));
+  }
+  settings.setValue("deviceReaderLimits", wDeviceLimits.join(','));
   settings.endGroup();
 }
 
@@ -113,12 +182,73 @@ void loadPreferences(MainWindow& iMainWindow)
 
   iMainWindow.resize(wSize);
   iMainWindow.move(wPosition);
-  iMainWindow.setSettings(Settings{ settings.value("autoPlay", false).toBool()
-                                    , static_cast<Settings::AudioMode>(settings.value("audioMode", 0).toUInt())
-                                    , settings.value("cursorTimeout", 500).toInt()
-                                    , settings.value("volume", 0.0f).toFloat()
-                                    , settings.value("randomize", false).toBool()
-    });
+  Settings wSettings{ settings.value("autoPlay", false).toBool()
+                      , static_cast<Settings::AudioMode>(settings.value("audioMode", 0).toUInt())
+                      , settings.value("cursorTimeout", 500).toInt()
+                      , settings.value("volume", 0.0f).toFloat()
+                      , settings.value("randomize", false).toBool()
+    };
+
+  // "1080,720,360", invalid or non positive entries are dropped
+  const QStringList wRenditions = settings.value("renditions", "1080,720,360").toString().split(',', Qt::SkipEmptyParts);
+  wSettings.mRenditionHeights.clear();
+  for (const QString& wRendition : wRenditions)
+  {
+    bool wOk = false;
+    const int wHeight = wRendition.trimmed().toInt(&wOk);
+    if (wOk && wHeight > 0)
+    {
+      wSettings.mRenditionHeights.push_back(wHeight);
+    }
+  }
+
+  wSettings.mCrop = settings.value("crop", QRectF(0.0, 0.0, 1.0, 1.0)).toRectF();
+  wSettings.mOutputHeight = settings.value("outputHeight", 0).toInt();
+  wSettings.mOutputFps = settings.value("outputFps", 0.0).toDouble();
+  wSettings.mOutputSpeed = settings.value("outputSpeed", 1.0).toDouble();
+  wSettings.mNormalizeAudio = settings.value("normalizeAudio", false).toBool();
+  wSettings.mTimeLapseSpeed = settings.value("timeLapseSpeed", 20.0).toDouble();
+  wSettings.mTimeLapseKeyframeStep = settings.value("timeLapseKeyframeStep", 1).toInt();
+  wSettings.mTimeLapseFps = settings.value("timeLapseFps", 30.0).toDouble();
+  wSettings.mAnimationFormat = static_cast<Settings::AnimationFormat>(settings.value("animationFormat", 0).toUInt());
+  wSettings.mAnimationWidth = settings.value("animationWidth", 480).toInt();
+  wSettings.mAnimationFps = settings.value("animationFps", 15.0).toDouble();
+  wSettings.mTargetSizeMB = settings.value("targetSizeMB", 50).toInt();
+  wSettings.mFragmentedOutput = settings.value("fragmentedOutput", true).toBool();
+  wSettings.mSpeculativeCut = settings.value("speculativeCut", true).toBool();
+  wSettings.mChapterRemux = settings.value("chapterRemux", true).toBool();
+  wSettings.mPrewarmNext = settings.value("prewarmNext", true).toBool();
+  wSettings.mFrameRingMB = settings.value("frameRingMB", 256).toInt();
+  wSettings.mReverseMaxHeight = settings.value("reverseMaxHeight", 720).toInt();
+  wSettings.mKeyframeRate = settings.value("keyframeRate", 3.0).toDouble();
+  wSettings.mPredecodeSeeks = settings.value("predecodeSeeks", true).toBool();
+  wSettings.mGridDecodeBudget = settings.value("gridDecodeBudget", 60).toInt();
+  wSettings.mGridTileHeight = settings.value("gridTileHeight", 270).toInt();
+  wSettings.mPrefetchCount = settings.value("prefetchCount", 3).toInt();
+  wSettings.mPrefetchHeadMB = settings.value("prefetchHeadMB", 4).toInt();
+  wSettings.mPrefetchBudgetMB = settings.value("prefetchBudgetMB", 64).toInt();
+  wSettings.mImageFormat = static_cast<Settings::ImageFormat>(settings.value("imageFormat", 0).toUInt());
+  wSettings.mFrameStep = settings.value("frameStep", 1).toInt();
+  wSettings.mBatchTemplate = static_cast<Settings::BatchTemplate>(settings.value("batchTemplate", 0).toUInt());
+  wSettings.mBatchLength = settings.value("batchLength", 15.0).toDouble();
+  wSettings.mMaxJobs = settings.value("maxJobs", 4).toInt();
+  wSettings.mReadersPerDevice = settings.value("readersPerDevice", 2).toInt();
+  wSettings.mWritersPerDevice = settings.value("writersPerDevice", 2).toInt();
+  wSettings.mThreadBudget = settings.value("threadBudget", 0).toInt();
+
+  // "hdd:2,ssd:6"
+  for (const QString& wLimit : settings.value("deviceReaderLimits", "").toString().split(',', Qt::SkipEmptyParts))
+  {
+    const QStringList wParts = wLimit.split(':');
+    bool wOk = false;
+    const int wValue = wParts.size() == 2 ? wParts[1].toInt(&wOk) : 0;
+    if (wOk && wValue > 0)
+    {
+      wSettings.mDeviceReaderLimits[wParts[0].trimmed()] = wValue;
+    }
+  }
+
+  iMainWindow.setSettings(wSettings);
   settings.endGroup();
 }
 
@@ -129,11 +259,9 @@ Playlist readPlaylistFile(const QString& iFilePath)
   if (wFile.is_open()) {
     std::string wLine;
     while (std::getline(wFile, wLine)) {
-      if (!wLine.empty()) {
-        if (wLine.front() == '"' && wLine.back() == '"') {
-          wLine = wLine.substr(1, wLine.size() - 2);
-        }
-        urls.push_back(QUrl::fromLocalFile(QString::fromStdString(wLine)));
+      const QUrl wUrl = Playlist::fromLine(QString::fromStdString(wLine)); // a file or a range of it
+      if (!wUrl.isEmpty()) {
+        urls.push_back(wUrl);
       }
     }
     wFile.close();